@@ -0,0 +1,213 @@
+/*
+ *  avx2.c
+ *  Goom
+ *
+ *  AVX2 versions of the zoom filter and of the output of convolve_fx : 8 pixels per loop.
+ *  This file is built with -mavx2, nothing in it may run before cpu_flavour
+ *  has found CPU_OPTION_AVX2.
+ */
+
+#ifdef HAVE_AVX2
+
+#include <immintrin.h>
+
+#include "simd.h"
+
+/* S + (D-S)*buffratio for 8 positions */
+static inline __m256i interpolate (const gint16 *brutS, const gint16 *brutD, __m256i ratio)
+{
+    __m256i s = _mm256_cvtepi16_epi32 (_mm_loadu_si128 ((const __m128i*)brutS));
+    __m256i d = _mm256_cvtepi16_epi32 (_mm_loadu_si128 ((const __m128i*)brutD));
+    return _mm256_add_epi32 (s, _mm256_srai_epi32 (_mm256_mullo_epi32 (_mm256_sub_epi32 (d, s), ratio), 16));
+}
+
+/* r,b (or g,a) channels of the 8 pixels, times the coeff of each pixel */
+static inline __m256i weight (__m256i col, __m256i coeffs, int shift)
+{
+    __m256i c = _mm256_and_si256 (_mm256_srli_epi32 (coeffs, shift), _mm256_set1_epi32 (0xff));
+    c = _mm256_or_si256 (c, _mm256_slli_epi32 (c, 16));
+    return _mm256_mullo_epi16 (col, c);
+}
+
+/* the 4 neighbours of the 8 positions, weighted by their coeffs */
+static inline __m256i blend8 (const int *pix, int prevX, __m256i pos, __m256i coeffs)
+{
+    const __m256i lowBytes = _mm256_set1_epi32 (0x00ff00ff);
+    const __m256i bias = _mm256_set1_epi16 (5);
+    __m256i col[4], rb, ga;
+    int i;
+
+    col[0] = _mm256_i32gather_epi32 (pix, pos, 4);
+    col[1] = _mm256_i32gather_epi32 (pix + 1, pos, 4);
+    col[2] = _mm256_i32gather_epi32 (pix + prevX, pos, 4);
+    col[3] = _mm256_i32gather_epi32 (pix + prevX + 1, pos, 4);
+
+    rb = ga = _mm256_setzero_si256 ();
+    for (i = 0; i < 4; ++i) {
+        rb = _mm256_add_epi16 (rb, weight (_mm256_and_si256 (col[i], lowBytes), coeffs, 8*i));
+        ga = _mm256_add_epi16 (ga, weight (_mm256_and_si256 (_mm256_srli_epi32 (col[i], 8), lowBytes), coeffs, 8*i));
+    }
+    rb = _mm256_srli_epi16 (_mm256_subs_epu16 (rb, bias), 8);
+    ga = _mm256_srli_epi16 (_mm256_subs_epu16 (ga, bias), 8);
+    return _mm256_or_si256 (rb, _mm256_slli_epi16 (ga, 8));
+}
+
+/* the C version does not touch the alpha channel of the dest */
+static inline __m256i alpha_mask (void)
+{
+    Pixel alpha;
+    alpha.val = 0;
+    alpha.channels.a = 0xff;
+    return _mm256_set1_epi32 ((int)alpha.val);
+}
+
+static inline void zoom_filter_avx2_ (int prevX, int prevY, int start, int end,
+                                      Pixel *expix1, Pixel *expix2,
+                                      const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio,
+                                      int precalCoef[16][16], int exact)
+{
+    const __m256i signBit = _mm256_set1_epi32 ((int)0x80000000);
+    const __m256i ax = _mm256_xor_si256 (_mm256_set1_epi32 ((prevX - 1) << 4), signBit);
+    const __m256i ay = _mm256_xor_si256 (_mm256_set1_epi32 ((prevY - 1) << 4), signBit);
+    const __m256i ratio = _mm256_set1_epi32 (buffratio);
+    const __m256i width = _mm256_set1_epi32 (prevX);
+    const __m256i alphaMask = alpha_mask ();
+    const int *coefs = &precalCoef[0][0];
+    const int *pix = (const int*)expix1;
+
+    int myPos = start;
+    int bufend = end;
+
+    for (; myPos + 8 <= bufend; myPos += 8) {
+        __m256i d, px, py, valid, pos, coeffs;
+
+        px = interpolate (brutS->x + myPos, brutD->x + myPos, ratio);
+        py = interpolate (brutS->y + myPos, brutD->y + myPos, ratio);
+
+        /* unsigned px < ax && py < ay, the others point at pixel 0 with null coeffs */
+        valid = _mm256_and_si256 (_mm256_cmpgt_epi32 (ax, _mm256_xor_si256 (px, signBit)),
+                                  _mm256_cmpgt_epi32 (ay, _mm256_xor_si256 (py, signBit)));
+        px = _mm256_and_si256 (px, valid);
+        py = _mm256_and_si256 (py, valid);
+
+        pos = _mm256_add_epi32 (_mm256_srli_epi32 (px, 4), _mm256_mullo_epi32 (_mm256_srli_epi32 (py, 4), width));
+        coeffs = _mm256_or_si256 (_mm256_slli_epi32 (_mm256_and_si256 (px, _mm256_set1_epi32 (0xf)), 4),
+                                  _mm256_and_si256 (py, _mm256_set1_epi32 (0xf)));
+        coeffs = _mm256_and_si256 (_mm256_i32gather_epi32 (coefs, coeffs, 4), valid);
+
+        d = blend8 (pix, prevX, pos, coeffs);
+
+        if (exact) {
+            __m256i old = _mm256_loadu_si256 ((__m256i*)(expix2 + myPos));
+            d = _mm256_blendv_epi8 (d, old, alphaMask);
+        }
+        _mm256_storeu_si256 ((__m256i*)(expix2 + myPos), d);
+    }
+
+    for (; myPos < bufend; ++myPos)
+        expix2[myPos] = zoom_pixel_c (prevX, prevY, myPos, expix1, expix2[myPos],
+                                      brutS, brutD, buffratio, precalCoef);
+}
+
+/* the alpha channel gets the zoomed alpha of the source */
+void zoom_filter_avx2 (int prevX, int prevY, int start, int end, Pixel *expix1, Pixel *expix2,
+                       const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16])
+{
+    zoom_filter_avx2_ (prevX, prevY, start, end, expix1, expix2, brutS, brutD, buffratio, precalCoef, 0);
+}
+
+/* same result than zoom_filter_c */
+void zoom_filter_avx2_exact (int prevX, int prevY, int start, int end, Pixel *expix1, Pixel *expix2,
+                             const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16])
+{
+    zoom_filter_avx2_ (prevX, prevY, start, end, expix1, expix2, brutS, brutD, buffratio, precalCoef, 1);
+}
+
+/* same result than zoom_filter_avx2_exact, the positions and coeffs are already there */
+void zoom_filter_steady_avx2 (int prevX, int start, int end, Pixel *expix1, Pixel *expix2,
+                              const guint32 *steady, const int coefs[ZOOM_STEADY_NB_COEFS])
+{
+    const __m256i coefMask = _mm256_set1_epi32 (ZOOM_STEADY_COEF_MASK);
+    const __m256i alphaMask = alpha_mask ();
+    const int *pix = (const int*)expix1;
+
+    int myPos = start;
+    int bufend = end;
+
+    for (; myPos + 8 <= bufend; myPos += 8) {
+        __m256i w = _mm256_loadu_si256 ((const __m256i*)(steady + myPos));
+        __m256i coeffs = _mm256_i32gather_epi32 (coefs, _mm256_and_si256 (w, coefMask), 4);
+        __m256i d = blend8 (pix, prevX, _mm256_srli_epi32 (w, ZOOM_STEADY_COEF_BITS), coeffs);
+        __m256i old = _mm256_loadu_si256 ((__m256i*)(expix2 + myPos));
+        _mm256_storeu_si256 ((__m256i*)(expix2 + myPos), _mm256_blendv_epi8 (d, old, alphaMask));
+    }
+
+    for (; myPos < bufend; ++myPos)
+        expix2[myPos] = zoom_steady_pixel_c (prevX, myPos, expix1, expix2[myPos], steady, coefs);
+}
+
+/* iff (32 bits) as [iff iff] 16 bits, above 0xffff any channel but 0 saturates anyway */
+static inline __m256i iff16 (__m256i iff)
+{
+    iff = _mm256_min_epu32 (iff, _mm256_set1_epi32 (0xffff));
+    return _mm256_or_si256 (iff, _mm256_slli_epi32 (iff, 16));
+}
+
+/* the 8 pixels times their iff16 >> 8, saturated, without alpha */
+static inline __m256i brighten8 (__m256i px, __m256i iff)
+{
+    const __m256i zero = _mm256_setzero_si256 ();
+    const __m256i max8 = _mm256_set1_epi16 (0xff);
+    const __m256i noAlpha = _mm256_xor_si256 (alpha_mask (), _mm256_set1_epi32 (-1));
+    /* (c << 8) * iff >> 16 == c * iff >> 8, in each 128 bits lane */
+    __m256i lo = _mm256_min_epu16 (_mm256_mulhi_epu16 (_mm256_unpacklo_epi8 (zero, px), _mm256_unpacklo_epi32 (iff, iff)), max8);
+    __m256i hi = _mm256_min_epu16 (_mm256_mulhi_epu16 (_mm256_unpackhi_epi8 (zero, px), _mm256_unpackhi_epi32 (iff, iff)), max8);
+    return _mm256_and_si256 (_mm256_packus_epi16 (lo, hi), noAlpha);
+}
+
+/* same result than create_output_with_brightness_c */
+void create_output_with_brightness_avx2 (Pixel *src, Pixel *dest, int n, int xtex, int ytex, int c, int s,
+                                         const int *texture)
+{
+    const __m256i wMask = _mm256_set1_epi32 (CONV_MOTIF_WMASK);
+    const __m256i dx = _mm256_set1_epi32 (8 * c);
+    const __m256i dy = _mm256_set1_epi32 (8 * s);
+    const __m256i steps = _mm256_setr_epi32 (1, 2, 3, 4, 5, 6, 7, 8);
+    __m256i tx = _mm256_add_epi32 (_mm256_set1_epi32 (xtex), _mm256_mullo_epi32 (steps, _mm256_set1_epi32 (c)));
+    __m256i ty = _mm256_sub_epi32 (_mm256_set1_epi32 (ytex), _mm256_mullo_epi32 (steps, _mm256_set1_epi32 (s)));
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i idx, iff;
+
+        idx = _mm256_or_si256 (_mm256_slli_epi32 (_mm256_and_si256 (_mm256_srai_epi32 (ty, 16), wMask), 7),
+                               _mm256_and_si256 (_mm256_srai_epi32 (tx, 16), wMask));
+        iff = iff16 (_mm256_i32gather_epi32 (texture, idx, 4));
+        _mm256_storeu_si256 ((__m256i*)(dest + i), brighten8 (_mm256_loadu_si256 ((const __m256i*)(src + i)), iff));
+
+        tx = _mm256_add_epi32 (tx, dx);
+        ty = _mm256_sub_epi32 (ty, dy);
+    }
+
+    if (i < n)
+        create_output_with_brightness_c (src + i, dest + i, n - i, xtex + i * c, ytex - i * s, c, s, texture);
+}
+
+/* same result than create_output_with_uniform_brightness_c */
+void create_output_with_uniform_brightness_avx2 (Pixel *src, Pixel *dest, int n, int iff)
+{
+    const __m256i iffV = iff16 (_mm256_set1_epi32 (iff));
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_loadu_si256 ((const __m256i*)(src + i));
+        __m256i b = _mm256_loadu_si256 ((const __m256i*)(src + i + 8));
+        _mm256_storeu_si256 ((__m256i*)(dest + i), brighten8 (a, iffV));
+        _mm256_storeu_si256 ((__m256i*)(dest + i + 8), brighten8 (b, iffV));
+    }
+
+    if (i < n)
+        create_output_with_uniform_brightness_c (src + i, dest + i, n - i, iff);
+}
+
+#endif /* HAVE_AVX2 */
@@ -7,12 +7,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-//#define CONV_MOTIF_W 32
-//#define CONV_MOTIF_WMASK 0x1f
-
-#define CONV_MOTIF_W 128
-#define CONV_MOTIF_WMASK 0x7f
-
 typedef char Motif[CONV_MOTIF_W][CONV_MOTIF_W];
 
 #include "motif_blank.h"
@@ -23,10 +17,15 @@ typedef char Motif[CONV_MOTIF_W][CONV_MOTIF_W];
 
 #define MAX 2.0f
 
+/* bands of the full screen output, as for the zoom (cf ZOOM_BANDS_PER_THREAD) */
+#define CONV_BANDS_PER_THREAD 4
+#define CONV_BAND_MIN_LINES 8
+
 typedef struct _CONV_DATA{
   PluginParam light;
   PluginParam factor_adj_p;
   PluginParam factor_p;
+  PluginParam fused_p;
   PluginParameters params;
 
   GoomSL *script;
@@ -40,6 +39,19 @@ typedef struct _CONV_DATA{
   float visibility;
   Motif conv_motif;
   int   inverse_motif;
+  int   motif_uniform;  /* all the texels of conv_motif are the same */
+
+  /* the output of the frame, cf convolve_prepare :
+   * the multiplier of each texel of the motif, or the one of the whole screen when uniform is set */
+  int   ifftab[16];
+  int   texture[CONV_MOTIF_W * CONV_MOTIF_W];
+  int   uniform;
+  int   uniform_iff;
+  int   copy;
+
+  /* the full screen output, cf convolve_band */
+  Pixel *src, *dest;
+  PluginInfo *info;
   
 } ConvData;
 
@@ -65,11 +77,15 @@ static void compute_tables(VisualFX *_this, PluginInfo *info)
   }
 }
 
-static void set_motif(ConvData *data, Motif motif)
+static void set_motif(ConvData *data, const Motif motif)
 {
   int i,j;
-  for (i=0;i<CONV_MOTIF_W;++i) for (j=0;j<CONV_MOTIF_W;++j)
+  data->motif_uniform = 1;
+  for (i=0;i<CONV_MOTIF_W;++i) for (j=0;j<CONV_MOTIF_W;++j) {
     data->conv_motif[i][j] = motif[CONV_MOTIF_W-i-1][CONV_MOTIF_W-j-1];
+    if (data->conv_motif[i][j] != motif[0][0])
+      data->motif_uniform = 0;
+  }
 }
 
 static void convolve_init(VisualFX *_this, PluginInfo *info) {
@@ -89,12 +105,16 @@ static void convolve_init(VisualFX *_this, PluginInfo *info) {
 
   data->factor_p = secure_f_feedback("Factor");
 
-  data->params = plugin_parameters ("Bright Flash", 5);
+  /* the output is done by the bands of the zoom, cf goom_update */
+  data->fused_p = secure_b_param("Fused Output", 0);
+
+  data->params = plugin_parameters ("Bright Flash", 6);
   data->params.params[0] = &data->light;
   data->params.params[1] = &data->factor_adj_p;
   data->params.params[2] = 0;
   data->params.params[3] = &data->factor_p;
   data->params.params[4] = 0;
+  data->params.params[5] = &data->fused_p;
 
   /* init rotozoom tables */
   compute_tables(_this, info);
@@ -103,6 +123,9 @@ static void convolve_init(VisualFX *_this, PluginInfo *info) {
   data->visibility = 1.0;
   set_motif(data, CONV_MOTIF_BLANK);
   data->inverse_motif = 0;
+  data->copy = 1;
+  data->src = data->dest = 0;
+  data->info = info;
 
   _this->params = &data->params;
 }
@@ -113,13 +136,56 @@ static void convolve_free(VisualFX *_this) {
   free (data);
 }
 
+/* the n pixels from src : the pixel k gets the multiplier of the texture at
+ * (xtex + (k+1)*c, ytex - (k+1)*s), in 16:16 fixed point. */
+void create_output_with_brightness_c(Pixel *src, Pixel *dest, int n, int xtex, int ytex, int c, int s,
+                                     const int *texture)
+{
+  int i;
+
+  for (i=0;i<n;++i) {
+
+    int iff2;
+    unsigned int f0,f1,f2,f3;
+    
+    xtex += c;
+    ytex -= s;
+    
+    iff2 = texture[(((ytex >>16) & CONV_MOTIF_WMASK) * CONV_MOTIF_W) + ((xtex >> 16) & CONV_MOTIF_WMASK)];
+
+#define sat(a) ((a)>0xFF?0xFF:(a))
+    f0 = src[i].val;
+    f1 = ((f0 >> R_OFFSET) & 0xFF) * iff2 >> 8;
+    f2 = ((f0 >> G_OFFSET) & 0xFF) * iff2 >> 8;
+    f3 = ((f0 >> B_OFFSET) & 0xFF) * iff2 >> 8;
+    dest[i].val = (sat(f1) << R_OFFSET) | (sat(f2) << G_OFFSET) | (sat(f3) << B_OFFSET);
+  }
+}
+
+/* same as create_output_with_brightness_c with the same multiplier for all the pixels */
+void create_output_with_uniform_brightness_c(Pixel *src, Pixel *dest, int n, int iff)
+{
+  int i;
+
+  for (i=0;i<n;++i) {
+    unsigned int f0,f1,f2,f3;
+
+    f0 = src[i].val;
+    f1 = ((f0 >> R_OFFSET) & 0xFF) * iff >> 8;
+    f2 = ((f0 >> G_OFFSET) & 0xFF) * iff >> 8;
+    f3 = ((f0 >> B_OFFSET) & 0xFF) * iff >> 8;
+    dest[i].val = (sat(f1) << R_OFFSET) | (sat(f2) << G_OFFSET) | (sat(f3) << B_OFFSET);
+  }
+}
+
+/* the pixels [x0..x1[ x [y0..y1[ of the output, with the state given by convolve_prepare */
 static void create_output_with_brightness(VisualFX *_this, Pixel *src, Pixel *dest,
-                                         PluginInfo *info, int iff)
+                                         PluginInfo *info, int x0, int y0, int x1, int y1)
 {
   ConvData *data = (ConvData*)_this->fx_data;
   
-  int x,y;
-  int i = 0;//info->screen.height * info->screen.width - 1;
+  int y;
+  int i;
 
   const int c = data->h_cos [data->theta];
   const int s = data->h_sin [data->theta];
@@ -130,150 +196,39 @@ static void create_output_with_brightness(VisualFX *_this, Pixel *src, Pixel *de
   const int xj = -(info->screen.height/2) * s;
   const int yj = -(info->screen.height/2) * c;
 
-  int xprime = xj;
-  int yprime = yj;
-
-  int ifftab[16];
-  if (data->inverse_motif) {
-    int i;
-    for (i=0;i<16;++i)
-      ifftab[i] = (double)iff * (1.0 + data->visibility * (15.0 - i) / 15.0);
-  }
-  else {
-    int i;
-    for (i=0;i<16;++i)
-      ifftab[i] = (double)iff / (1.0 + data->visibility * (15.0 - i) / 15.0);
-  }
-
-  for (y=info->screen.height;y--;) {
+  for (y=y0;y<y1;++y) {
     int xtex,ytex;
 
-    xtex = xprime + xi + CONV_MOTIF_W * 0x10000 / 2;
-    xprime += s;
-
-    ytex = yprime + yi + CONV_MOTIF_W * 0x10000 / 2;
-    yprime += c;
-
-#ifdef HAVE_MMX
-    __asm__ __volatile__
-      ("\n\t pxor  %%mm7,  %%mm7"  /* mm7 = 0   */
-       "\n\t movd %[xtex],  %%mm2"
-       "\n\t movd %[ytex],  %%mm3"
-       "\n\t punpckldq %%mm3, %%mm2" /* mm2 = [ ytex | xtex ] */
-       "\n\t movd %[c],     %%mm4"
-       "\n\t movd %[s],     %%mm6"
-       "\n\t pxor  %%mm5,   %%mm5"
-       "\n\t psubd %%mm6,   %%mm5"
-       "\n\t punpckldq %%mm5, %%mm4" /* mm4 = [ -s | c ]      */
-       "\n\t movd %[motif], %%mm6"   /* mm6 = motif           */
-
-       ::[xtex]"g"(xtex) ,[ytex]"g"(ytex)
-        , [c]"g"(c), [s]"g"(s)
-        , [motif] "g"(&data->conv_motif[0][0]));
-    
-    for (x=info->screen.width;x--;)
-    {
-      __asm__ __volatile__
-        (
-         "\n\t movd  %[src], %%mm0"  /* mm0 = src */
-         "\n\t paddd %%mm4, %%mm2"   /* [ ytex | xtex ] += [ -s | s ] */
-         "\n\t movd  %%esi, %%mm5"   /* save esi into mm5 */
-         "\n\t movq  %%mm2, %%mm3"
-         "\n\t psrld  $16,  %%mm3"   /* mm3 = [ (ytex>>16) | (xtex>>16) ] */
-         "\n\t movd  %%mm3, %%eax"   /* eax = xtex' */
-
-         "\n\t psrlq $25,   %%mm3"
-         "\n\t movd  %%mm3, %%ecx"   /* ecx = ytex' << 7 */
-
-         "\n\t andl  $127, %%eax"
-         "\n\t andl  $16256, %%ecx"
-         
-         "\n\t addl  %%ecx, %%eax"
-         "\n\t movd  %%mm6, %%esi"   /* esi = motif */
-         "\n\t xorl  %%ecx, %%ecx"
-         "\n\t movb  (%%eax,%%esi), %%cl"
-
-         "\n\t movl  %[ifftab], %%eax"
-         "\n\t movd  %%mm5, %%esi"    /* restore esi from mm5 */
-         "\n\t movd  (%%eax,%%ecx,4), %%mm1" /* mm1 = [0|0|0|iff2] */
-
-         "\n\t punpcklwd %%mm1, %%mm1"
-         "\n\t punpcklbw %%mm7, %%mm0"
-         "\n\t punpckldq %%mm1, %%mm1"
-         "\n\t psrlw     $1,    %%mm0"
-         "\n\t psrlw     $2,    %%mm1"
-         "\n\t pmullw    %%mm1, %%mm0"
-         "\n\t psrlw     $5,    %%mm0"
-         "\n\t packuswb  %%mm7, %%mm0"
-         "\n\t movd      %%mm0, %[dest]"
-         : [dest] "=g" (dest[i].val)
-         : [src]   "g"  (src[i].val)
-         , [ifftab]"g"(&ifftab[0])
-         : "eax","ecx");
-
-      i++;
-    }
-#else
-    for (x=info->screen.width;x--;) {
-
-      int iff2;
-      unsigned int f0,f1,f2,f3;
-      
-      xtex += c;
-      ytex -= s;
-      
-      iff2 = ifftab[data->conv_motif[(ytex >>16) & CONV_MOTIF_WMASK][(xtex >> 16) & CONV_MOTIF_WMASK]];
+    /* the texture coordinates move by (s,c) on each line, by (c,-s) on each pixel */
+    xtex = xj + y * s + xi + CONV_MOTIF_W * 0x10000 / 2 + x0 * c;
+    ytex = yj + y * c + yi + CONV_MOTIF_W * 0x10000 / 2 - x0 * s;
+    i = y * info->screen.width + x0;
 
-#define sat(a) ((a)>0xFF?0xFF:(a))
-      f0 = src[i].val;
-      f1 = ((f0 >> R_OFFSET) & 0xFF) * iff2 >> 8;
-      f2 = ((f0 >> G_OFFSET) & 0xFF) * iff2 >> 8;
-      f3 = ((f0 >> B_OFFSET) & 0xFF) * iff2 >> 8;
-      dest[i].val = (sat(f1) << R_OFFSET) | (sat(f2) << G_OFFSET) | (sat(f3) << B_OFFSET);
-/*
-      f0 = (src[i].cop[0] * iff2) >> 8;
-      f1 = (src[i].cop[1] * iff2) >> 8;
-      f2 = (src[i].cop[2] * iff2) >> 8;
-      f3 = (src[i].cop[3] * iff2) >> 8;
-
-      dest[i].cop[0] = (f0 & 0xffffff00) ? 0xff : (unsigned char)f0;
-      dest[i].cop[1] = (f1 & 0xffffff00) ? 0xff : (unsigned char)f1;
-      dest[i].cop[2] = (f2 & 0xffffff00) ? 0xff : (unsigned char)f2;
-      dest[i].cop[3] = (f3 & 0xffffff00) ? 0xff : (unsigned char)f3;
-*/
-      i++;
-    }
-#endif 
+    info->methods.create_output_with_brightness(src + i, dest + i, x1 - x0, xtex, ytex, c, s, data->texture);
   }
-#ifdef HAVE_MMX
-  __asm__ __volatile__ ("\n\t emms");
-#endif
-    
-  compute_tables(_this, info);
 }
 
 
-/*#include <stdint.h>
-
-static uint64_t GetTick()
-{
-  uint64_t x;
-  asm volatile ("RDTSC" : "=A" (x));
-  return x;
-}*/
-
+int convolve_fused(VisualFX *_this) {
+  ConvData *data = (ConvData*)_this->fx_data;
+  return BVAL(data->fused_p);
+}
 
-static void convolve_apply(VisualFX *_this, Pixel *src, Pixel *dest, PluginInfo *info) {
+int convolve_prepare(VisualFX *_this, PluginInfo *info, guint32 cycle) {
 
   ConvData *data = (ConvData*)_this->fx_data;
   float ff;
   int iff;
+  int i;
   
+  compute_tables(_this, info);
+
   ff = (FVAL(data->factor_p) * FVAL(data->factor_adj_p) + FVAL(data->light) ) / 100.0f;
+  ff *= info->outputFade;
   iff = (unsigned int)(ff * 256);
 
   {
-    double fcycle = (double)info->cycle;
+    double fcycle = (double)cycle;
     double rotate_param, rotate_coef;
     float INCREASE_RATE = 1.5;
     float DECAY_RATE = 0.955;
@@ -306,27 +261,91 @@ static void convolve_apply(VisualFX *_this, Pixel *src, Pixel *dest, PluginInfo
   }
 ***/  
 
-  if ((ff > 0.98f) && (ff < 1.02f))
-    memcpy(dest, src, info->screen.size * sizeof(Pixel));
-  else
-    create_output_with_brightness(_this,src,dest,info,iff);
-/*
-//   Benching suite...
-   {
-    uint64_t before, after;
-    double   timed;
-    static double stimed = 10000.0;
-    before = GetTick();
-    data->visibility = 1.0;
-    create_output_with_brightness(_this,src,dest,info,iff);
-    after  = GetTick();
-    timed = (double)((after-before) / info->screen.size);
-    if (timed < stimed) {
-      stimed = timed;
-      printf ("CLK = %3.0f CPP\n", stimed);
+  data->copy = (ff > 0.98f) && (ff < 1.02f);
+  if (data->inverse_motif) {
+    for (i=0;i<16;++i)
+      data->ifftab[i] = (double)iff * (1.0 + data->visibility * (15.0 - i) / 15.0);
+  }
+  else {
+    for (i=0;i<16;++i)
+      data->ifftab[i] = (double)iff / (1.0 + data->visibility * (15.0 - i) / 15.0);
+  }
+
+  /* the blank motif (the fly-in is disabled), or no visibility :
+   * the same multiplier everywhere, the rotozoom is useless */
+  data->uniform = data->motif_uniform;
+  for (i=1;(i<16)&&(data->ifftab[i]==data->ifftab[0]);++i);
+  if (i == 16)
+    data->uniform = 1;
+  data->uniform_iff = data->ifftab[(int)data->conv_motif[0][0]];
+
+  if (!data->copy && !data->uniform) {
+    const char *motif = &data->conv_motif[0][0];
+    for (i=0;i<CONV_MOTIF_W*CONV_MOTIF_W;++i)
+      data->texture[i] = data->ifftab[(int)motif[i]];
+  }
+  return data->copy;
+}
+
+void convolve_output(VisualFX *_this, Pixel *src, Pixel *dest, PluginInfo *info, int x0, int y0, int x1, int y1) {
+
+  ConvData *data = (ConvData*)_this->fx_data;
+  int y;
+
+  if (!data->copy && !data->uniform)
+    create_output_with_brightness(_this,src,dest,info,x0,y0,x1,y1);
+  else if ((x0 == 0) && (x1 == info->screen.width)) {
+    /* whole lines : one run */
+    int i = y0 * x1, n = (y1 - y0) * x1;
+    if (data->copy)
+      memcpy(dest + i, src + i, n * sizeof(Pixel));
+    else
+      info->methods.create_output_with_uniform_brightness(src + i, dest + i, n, data->uniform_iff);
+  }
+  else {
+    for (y=y0;y<y1;++y) {
+      int i = y * info->screen.width + x0;
+      if (data->copy)
+        memcpy(dest + i, src + i, (x1 - x0) * sizeof(Pixel));
+      else
+        info->methods.create_output_with_uniform_brightness(src + i, dest + i, x1 - x0, data->uniform_iff);
     }
   }
-*/
+}
+
+/* the lines of one band of the screen, each pixel only depends on its source */
+static void convolve_band(void *arg, int band, int nbBands) {
+
+  VisualFX *_this = (VisualFX*)arg;
+  ConvData *data = (ConvData*)_this->fx_data;
+  int height = data->info->screen.height;
+
+  convolve_output(_this, data->src, data->dest, data->info, 0, (height * band) / nbBands,
+                  data->info->screen.width, (height * (band + 1)) / nbBands);
+}
+
+void convolve_output_screen(VisualFX *_this, Pixel *src, Pixel *dest, PluginInfo *info) {
+
+  ConvData *data = (ConvData*)_this->fx_data;
+  int nbBands = goom_thread_pool_size(info->threads);
+
+  if (nbBands > 1)
+    nbBands *= CONV_BANDS_PER_THREAD;
+  if (nbBands > info->screen.height / CONV_BAND_MIN_LINES)
+    nbBands = info->screen.height / CONV_BAND_MIN_LINES;
+  if (nbBands < 1)
+    nbBands = 1;
+
+  data->src = src;
+  data->dest = dest;
+  data->info = info;
+  goom_thread_pool_run(info->threads, nbBands, convolve_band, _this);
+}
+
+static void convolve_apply(VisualFX *_this, Pixel *src, Pixel *dest, PluginInfo *info) {
+
+  convolve_prepare(_this, info, info->cycle);
+  convolve_output_screen(_this, src, dest, info);
 }
 
 VisualFX convolve_create(void) {
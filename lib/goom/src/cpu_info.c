@@ -9,6 +9,8 @@
 
 #include "cpu_info.h"
 
+#include <stdatomic.h>
+
 #ifdef CPU_X86
 #include "mmx.h"
 #endif
@@ -18,13 +20,24 @@
 #include <stdlib.h>
 #endif
 
-static unsigned int CPU_FLAVOUR = 0;
-static unsigned int CPU_NUMBER = 1;
-static unsigned int CPU_DETECTED = 0;
+#ifndef _WIN32PC
+#include <unistd.h>
+#endif
+
+#if (defined(HAVE_SSE2) || defined(HAVE_AVX2)) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/* found by the first call, from any thread. two threads may look at the same
+ * time, they find the same */
+static atomic_uint CPU_FLAVOUR;
+static atomic_uint CPU_NUMBER;
+static atomic_int CPU_DETECTED;
 
 static void autoset_cpu_info (void)
 {
-    CPU_DETECTED = 1;
+    unsigned int flavour = 0;
+    unsigned int number = 1;
     
 #ifdef CPU_POWERPC
     int result;
@@ -34,38 +47,76 @@ static void autoset_cpu_info (void)
     size = 4;
     if (sysctlbyname("hw.optional.altivec",&result,&size,NULL,NULL) == 0)
     {
-        if (result != 0) CPU_FLAVOUR |= CPU_OPTION_ALTIVEC;
+        if (result != 0) flavour |= CPU_OPTION_ALTIVEC;
     }
     
     result = 0;
     size = 4;
     if (sysctlbyname("hw.optional.64bitops",&result,&size,NULL,NULL) == 0)
     {
-        if (result != 0) CPU_FLAVOUR |= CPU_OPTION_64_BITS;
+        if (result != 0) flavour |= CPU_OPTION_64_BITS;
     }
     
     result = 0;
     size = 4;
     if (sysctlbyname("hw.ncpu",&result,&size,NULL,NULL) == 0)
     {
-        if (result != 0) CPU_NUMBER = result;
+        if (result != 0) number = result;
     }
 #endif /* CPU_POWERPC */
     
 #ifdef CPU_X86
-    if (mmx_supported()) CPU_FLAVOUR |= CPU_OPTION_MMX;
-    if (xmmx_supported()) CPU_FLAVOUR |= CPU_OPTION_XMMX;
+    if (mmx_supported()) flavour |= CPU_OPTION_MMX;
+    if (xmmx_supported()) flavour |= CPU_OPTION_XMMX;
 #endif /* CPU_X86 */
+
+#if defined(HAVE_SSE2) || defined(HAVE_AVX2)
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse")) flavour |= CPU_OPTION_SSE;
+    if (__builtin_cpu_supports("sse2")) flavour |= CPU_OPTION_SSE2;
+    if (__builtin_cpu_supports("avx2")) flavour |= CPU_OPTION_AVX2;
+#elif defined(_MSC_VER)
+    {
+        /* always there on x86-64 */
+        int regs[4];
+        flavour |= CPU_OPTION_SSE | CPU_OPTION_SSE2;
+
+        /* avx2 : cpuid 7 ebx bit 5, and the os must save the ymm registers */
+        __cpuid(regs, 1);
+        if ((regs[2] & (1 << 27)) && ((_xgetbv(0) & 6) == 6)) {
+            __cpuidex(regs, 7, 0);
+            if (regs[1] & (1 << 5)) flavour |= CPU_OPTION_AVX2;
+        }
+    }
+#endif
+#endif /* HAVE_SSE2 || HAVE_AVX2 */
+
+#ifdef HAVE_NEON
+    /* always there on aarch64, the only target built with it */
+    flavour |= CPU_OPTION_NEON;
+#endif /* HAVE_NEON */
+
+#if !defined(CPU_POWERPC) && defined(_SC_NPROCESSORS_ONLN)
+    {
+        long result = sysconf(_SC_NPROCESSORS_ONLN);
+        if (result > 0) number = (unsigned int)result;
+    }
+#endif
+
+    atomic_store_explicit (&CPU_FLAVOUR, flavour, memory_order_relaxed);
+    atomic_store_explicit (&CPU_NUMBER, number, memory_order_relaxed);
+    atomic_store_explicit (&CPU_DETECTED, 1, memory_order_release);
 }
 
 unsigned int cpu_flavour (void)
 {
-    if (CPU_DETECTED == 0) autoset_cpu_info();
-    return CPU_FLAVOUR;
+    if (atomic_load_explicit (&CPU_DETECTED, memory_order_acquire) == 0) autoset_cpu_info();
+    return atomic_load_explicit (&CPU_FLAVOUR, memory_order_relaxed);
 }
 
 unsigned int cpu_number (void)
 {
-    if (CPU_DETECTED == 0) autoset_cpu_info();
-    return CPU_NUMBER;
+    if (atomic_load_explicit (&CPU_DETECTED, memory_order_acquire) == 0) autoset_cpu_info();
+    return atomic_load_explicit (&CPU_NUMBER, memory_order_relaxed);
 }
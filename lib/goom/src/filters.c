@@ -19,6 +19,12 @@
 #include <math.h>
 #include <stdio.h>
 #include <inttypes.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <time.h>
+#ifndef _WIN32PC
+#include <pthread.h>
+#endif
 
 #include "goom_filters.h"
 #include "goom_graphic.h"
@@ -83,44 +89,141 @@ static inline void getPixelRGB_ (Pixel *buffer, Uint x, Color * c)
 /* faire : a / sqrtperte <=> a >> PERTEDEC */
 #define PERTEDEC 4
 
+/* minimum number of lines given to a thread by the zoom filter */
+#define ZOOM_BAND_MIN_LINES 8
+/* number of bands per thread, more bands gives a better balance between the threads */
+#define ZOOM_BANDS_PER_THREAD 4
+
+/* tile sizes tried by tuneZoomTiles, 0x0 : line by line */
+static const int zoomTileSizes[][2] = {
+    {0, 0}, {32, 32}, {64, 16}, {64, 32}, {128, 16}, {128, 32}, {256, 8}
+};
+#define ZOOM_TILE_TUNE_PASSES 2
+
 /* pure c version of the zoom filter */
-static void c_zoom (Pixel *expix1, Pixel *expix2, unsigned int prevX, unsigned int prevY, signed int *brutS, signed int *brutD, int buffratio, int precalCoef[BUFFPOINTNB][BUFFPOINTNB]);
+static void c_zoom (Pixel *expix1, Pixel *expix2, unsigned int prevX, unsigned int prevY, int start, int end,
+                    const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[BUFFPOINTNB][BUFFPOINTNB]);
 
 /* simple wrapper to give it the same proto than the others */
-void zoom_filter_c (int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16]) {
-    c_zoom(src, dest, sizeX, sizeY, brutS, brutD, buffratio, precalCoef);
+void zoom_filter_c (int sizeX, int sizeY, int start, int end, Pixel *src, Pixel *dest, const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16]) {
+    c_zoom(src, dest, sizeX, sizeY, start, end, brutS, brutD, buffratio, precalCoef);
+}
+
+/* pure c version of the zoom filter, from the collapsed transform */
+static void c_zoom_steady (Pixel *expix1, Pixel *expix2, unsigned int prevX, int start, int end,
+                           const guint32 *steady, const int coefs[ZOOM_STEADY_NB_COEFS]);
+
+void zoom_filter_steady_c (int sizeX, int start, int end, Pixel *src, Pixel *dest, const guint32 *steady, const int coefs[ZOOM_STEADY_NB_COEFS]) {
+    c_zoom_steady(src, dest, sizeX, start, end, steady, coefs);
 }
 
 static void generatePrecalCoef (int precalCoef[BUFFPOINTNB][BUFFPOINTNB]);
 
+/** everything the zoom vectors depend on (cf zoomVector) */
+typedef struct _ZOOM_MAP_CONFIG {
+    unsigned int prevX, prevY;
+    
+    float general_speed;
+    char theMode;
+    int waveEffect;
+    int hypercosEffect;
+    int vPlaneEffect;
+    int hPlaneEffect;
+    char noisify;
+    guint32 noiseSeed; /* cf zoomNoiseHash */
+    int middleX, middleY;
+} ZoomMapConfig;
+
+/** what is asked to the background generation */
+typedef struct _ZOOM_MAP_REQUEST {
+    ZoomMapConfig config;
+    int cacheBytes; /* memory allowed to the map cache */
+} ZoomMapRequest;
+
+/** a transform buffer, passed between the render thread and the background generation.
+ * a buffer of mapPool : this struct, then the two planes (cf newZoomMap) */
+typedef struct _ZOOM_MAP {
+    ZoomTransform brut;
+    Uint size; /* number of pixels */
+} ZoomMap;
+
+/** a map already computed, kept by the map cache */
+typedef struct _ZOOM_MAP_CACHE_ENTRY {
+    ZoomMapConfig config;
+    ZoomMap *map;
+    unsigned int lastUse;
+} ZoomMapCacheEntry;
+
+/* max number of maps in the cache, the memory budget is the real limit */
+#define ZOOM_MAP_CACHE_MAX 64
+
 
 typedef struct _ZOOM_FILTER_FX_WRAPPER_DATA {
     
     PluginParam enabled_bp;
+    PluginParam exact_bp; /* same result than the C zoom, whatever the cpu */
     PluginParameters params;
     
     unsigned int *coeffs, *freecoeffs;
     
-    signed int *brutS, *freebrutS; /* source */
-    signed int *brutD, *freebrutD; /* dest */
-    signed int *brutT, *freebrutT; /* temp (en cours de generation) */
+    ZoomTransform brutS; ZoomMap *mapS; /* source, in mapS */
+    ZoomMap *mapD;                      /* dest */
+    
+    /** all of them from the arena of goomInfo, made for the size of goom_init at least,
+     * kept when the size goes down */
+    GoomPool *mapPool;
+    Uint bufferSize;  /* pixels of the maps and of steady */
+    Uint bufferWidth; /* columns of rows */
+    float *rows[2];   /* makeZoomBuffer : [0] render thread, [1] background generation */
+    Uint initX, initY; /* size of goom_init, the biggest one */
+    
+    /** maps of the background generation, see generateZoomMap */
+    GoomBackgroundTask *mapTask;
+    _Atomic(ZoomMap *) nextMap;  /* last map generated, not used yet */
+    _Atomic(ZoomMap *) spareMap; /* map given back by the render thread */
+#ifndef _WIN32PC
+    pthread_mutex_t mapLock;     /* the background generation waits for spareMap */
+    pthread_cond_t mapGiven;
+#endif
+    
+    /** maps of the last configs, only used by the background generation */
+    ZoomMapCacheEntry mapCache[ZOOM_MAP_CACHE_MAX];
+    int mapCacheSize;
+    unsigned int mapCacheClock;
+    atomic_int mapCacheHits, mapCacheMisses;
+    GoomProfile *profile; /* of goomInfo, the background generation is a stage of its own */
+    
+    PluginParam cache_size_p; /* MB */
+    PluginParam cache_hits_p;
+    PluginParam cache_misses_p;
+    
+    /** the destination can be zoomed by 2D tiles, the source fetches then stay in the cache */
+    PluginParam tiled_bp;
+    PluginParam tile_width_p;  /* 0 : line by line */
+    PluginParam tile_height_p; /* set by tuneZoomTiles, can be changed after */
+    int mustTuneTiles;
+    
+    /** regime etabli : buffratio did not move since the last frame, see makeSteadyZoom */
+    guint32 *steady;
+    int steadyCoefs[ZOOM_STEADY_NB_COEFS];
+    int steadyValid;   /* steady is made from brutS, mapD and buffratio */
+    int useSteady;     /* for the bands of this frame */
+    int lastBuffratio;
     
     guint32 zoom_width;
     
     unsigned int prevX, prevY;
     
-    float general_speed;
     int reverse; /* reverse the speed */
-    char theMode;
-    int waveEffect;
-    int hypercosEffect;
-    int vPlaneEffect;
-    int hPlaneEffect;
-    char noisify;
-    int middleX, middleY;
+    ZoomMapConfig config;
     
     int mustInitBuffers;
-    int interlace_start;
+    
+    /** used by the zoom bands */
+    PluginInfo *goomInfo;
+    Pixel *src, *dest;
+    /* goomInfo->zoomBandHook of the frame, not called by the tuning */
+    void (*bandHook) (PluginInfo *goomInfo, int yStart, int yEnd);
     
     /** modif by jeko : fixedpoint : buffration = (16:16) (donc 0<=buffration<=2^16) */
     int buffratio;
@@ -138,141 +241,349 @@ typedef struct _ZOOM_FILTER_FX_WRAPPER_DATA {
 
 
 
-static inline v2g zoomVector(ZoomFilterFXWrapperData *data, float X, float Y)
-{
-    v2g vecteur;
-    float vx, vy;
-    float sq_dist = X*X + Y*Y;
-    
-    /*    sx = (X < 0.0f) ? -1.0f : 1.0f;
-    sy = (Y < 0.0f) ? -1.0f : 1.0f;
-    */  
-    float coefVitesse = (1.0f+ data->general_speed) / 50.0f;
-    
-    // Effects
-    
-    /* Centralized FX */
-    
-    switch (data->theMode) {
-        case CRYSTAL_BALL_MODE:
-            coefVitesse -= (sq_dist-0.3f)/15.0f;
-            break;
-        case AMULETTE_MODE:
-            coefVitesse += sq_dist * 3.5f;
-            break;
-        case WAVE_MODE:
-            coefVitesse += sin(sq_dist*20.0f) / 100.0f;
-            break;
-        case SCRUNCH_MODE:
-            coefVitesse += sq_dist / 10.0f;
-            break;
-            //case HYPERCOS1_MODE:
-            break;
-            //case HYPERCOS2_MODE:
-            break;
-            //case YONLY_MODE:
-            break;
-        case SPEEDWAY_MODE:
-            coefVitesse *= 4.0f * Y;
-            break;
-        default:
-            break;
-    }
-    
-    if (coefVitesse < -2.01f)
-        coefVitesse = -2.01f;
-    if (coefVitesse > 2.01f)
-        coefVitesse = 2.01f;
-    
-    vx = coefVitesse * X;
-    vy = coefVitesse * Y;
+/* the map is generated by rows : the loops on the rows have no branch nor
+ * aliasing, the compiler turns them into SIMD code (-O3 / -ftree-vectorize).
+ * the rows are padded to a multiple of ZOOM_ROW_BLOCK floats. */
+#define ZOOM_ROW_BLOCK 8
+
+/* sinus polynomial, without branch nor libm call so that it can be vectorized.
+ * |error| < 1e-6 on the range used by the zoom */
+static inline float zoomSin (float x)
+{
+    /* x = k*pi + r, |r| <= pi/2 */
+    float k = (float)(int)(x * 0.318309886f + ((x < 0.0f) ? -0.5f : 0.5f));
+    float r = (x - k * 3.140625f) - k * 9.67653589e-4f;
+    float r2 = r * r;
+    float s = r + r * r2 * (-1.66666667e-1f + r2 * (8.33333333e-3f + r2 * (-1.98412698e-4f
+                  + r2 * (2.75573192e-6f + r2 * -2.50521084e-8f))));
+    return ((int)k & 1) ? -s : s;
+}
+
+/*
+ * coefVitesse of the pixels of a row, one function per mode.
+ * X : the positions of the columns, Y : the position of the row (normalized coordinates)
+ */
+typedef void (*ZoomSpeedRowFunc) (float base, float Y, const float *restrict X, float *restrict coef, Uint n);
+
+#define ZOOM_SPEED_ROW(_name, _coef) \
+static void _name (float base, float Y, const float *restrict X, float *restrict coef, Uint n) \
+{ \
+    Uint x; \
+    for (x = 0; x < n; x++) { \
+        float sq_dist = X[x]*X[x] + Y*Y; \
+        float coefVitesse = (_coef); \
+        (void)sq_dist; \
+        coefVitesse = (coefVitesse < -2.01f) ? -2.01f : coefVitesse; \
+        coef[x] = (coefVitesse > 2.01f) ? 2.01f : coefVitesse; \
+    } \
+}
+
+ZOOM_SPEED_ROW (speedRowNormal,   base)
+ZOOM_SPEED_ROW (speedRowCrystal,  base - (sq_dist-0.3f)/15.0f)
+ZOOM_SPEED_ROW (speedRowAmulette, base + sq_dist * 3.5f)
+ZOOM_SPEED_ROW (speedRowWave,     base + zoomSin(sq_dist*20.0f) / 100.0f)
+ZOOM_SPEED_ROW (speedRowScrunch,  base + sq_dist / 10.0f)
+ZOOM_SPEED_ROW (speedRowSpeedway, base * 4.0f * Y)
+
+/* indexed by the *_MODE */
+static const ZoomSpeedRowFunc zoomSpeedRows[] = {
+    speedRowNormal,   /* NORMAL_MODE */
+    speedRowWave,     /* WAVE_MODE */
+    speedRowCrystal,  /* CRYSTAL_BALL_MODE */
+    speedRowScrunch,  /* SCRUNCH_MODE */
+    speedRowAmulette, /* AMULETTE_MODE */
+    speedRowNormal,   /* WATER_MODE : TODO */
+    speedRowNormal,   /* HYPERCOS1_MODE */
+    speedRowNormal,   /* HYPERCOS2_MODE */
+    speedRowNormal,   /* YONLY_MODE */
+    speedRowSpeedway, /* SPEEDWAY_MODE */
+};
+
+/* noise of the map : a hash of the pixel and of the seed of the config.
+ * no state (random() locks and is not reproducible), the same config gives the same map. */
+static inline guint32 zoomNoiseHash (guint32 pos, guint32 seed)
+{
+    guint32 h = (pos * 0x9e3779b9u) ^ seed;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
+/* positions out of the int16 range are saturated, they are out of the screen anyway */
+static inline gint16 zoomClamp (int v)
+{
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return (gint16)v;
+}
+
+/* the planes of the maps start one GOOM_ARENA_ALIGN after the struct, each one aligned */
+static Uint zoomPlaneSize (Uint size)
+{
+    return (size + GOOM_ARENA_ALIGN - 1) & ~(GOOM_ARENA_ALIGN - 1);
+}
+
+static GoomPool *newZoomMapPool (GoomArena *arena, Uint size)
+{
+    return goom_pool_new (arena, GOOM_ARENA_ALIGN + 2 * zoomPlaneSize (size) * sizeof(gint16));
+}
+
+/* a map of size pixels, the buffers of the pool may be bigger */
+static ZoomMap *newZoomMap (GoomPool *pool, Uint size)
+{
+    ZoomMap *map = (ZoomMap *) goom_pool_take (pool);
+    Uint planeSize = (goom_pool_buffer_size (pool) - GOOM_ARENA_ALIGN) / (2 * sizeof(gint16));
     
-    /* Amulette 2 */
-    // vx = X * tan(dist);
-    // vy = Y * tan(dist);
+    map->brut.x = (gint16 *) ((char *) map + GOOM_ARENA_ALIGN);
+    map->brut.y = map->brut.x + planeSize;
+    map->size = size;
+    return map;
+}
+
+static void freeZoomMap (ZoomMap *map)
+{
+    goom_pool_give (map);
+}
+
+/*
+ * Makes a transform buffer
+ *
+ * The transform is (in order) :
+ * Translation (-config->middleX, -config->middleY)
+ * Homothetie (Center : 0,0   Coeff : 2/config->prevX)
+ */
+/* positions (relative to the middle) of the pixels of a row */
+static void zoomRowPositions (float Y, float addX, float min, float inv_ratio,
+                              const float *restrict X, const float *restrict addY, const float *restrict coef,
+                              const float *restrict noiseX, const float *restrict noiseY,
+                              float *restrict px, float *restrict py, Uint n)
+{
+    Uint x;
+    for (x = 0; x < n; x++) {
+        float vx = coef[x] * X[x] + noiseX[x] + addX;
+        float vy = coef[x] * Y + noiseY[x] + addY[x];
+        float fx, fy;
+        
+        /* Finish and avoid null displacement */
+        vx = (fabsf(vx) < min) ? ((vx < 0.0f) ? -min : min) : vx;
+        vy = (fabsf(vy) < min) ? ((vy < 0.0f) ? -min : min) : vy;
+        
+        /* big enough to saturate the int16 after the translation */
+        fx = (X[x] - vx) * inv_ratio;
+        fy = (Y - vy) * inv_ratio;
+        px[x] = (fx < -70000.0f) ? -70000.0f : ((fx > 70000.0f) ? 70000.0f : fx);
+        py[x] = (fy < -70000.0f) ? -70000.0f : ((fy > 70000.0f) ? 70000.0f : fy);
+    }
+}
+
+/* rows : 7 * prevX floats (rounded up to ZOOM_ROW_BLOCK) */
+static void makeZoomBuffer(const ZoomMapConfig *config, ZoomTransform *brut, float *rows)
+{
+    // Position of the pixel to compute in pixmap coordinates
+    Uint x, y;
+    // Ratio from pixmap to normalized coordinates
+    float ratio = 2.0f/((float)config->prevX);
+    // Ratio from normalized to virtual pixmap coordinates
+    float inv_ratio = BUFFPOINTNBF/ratio;
+    float min = ratio/BUFFPOINTNBF;
     
-    /* Rotate */
-    //vx = (X+Y)*0.1;
-    //vy = (Y-X)*0.1;
+    float base = (1.0f + config->general_speed) / 50.0f;
+    ZoomSpeedRowFunc speedRow = speedRowNormal;
     
+    /* rows of ZOOM_ROW_BLOCK multiple */
+    Uint n = (config->prevX + ZOOM_ROW_BLOCK - 1) & ~(ZOOM_ROW_BLOCK - 1);
+    float *X = rows;           /* X of the columns */
+    float *addY = rows + n;    /* what vy gets from the column effects */
+    float *coef = rows + 2*n;
+    float *noiseX = rows + 3*n;
+    float *noiseY = rows + 4*n;
+    float *px = rows + 5*n;
+    float *py = rows + 6*n;
     
-    // Effects adds-on
+    memset (rows, 0, 7 * n * sizeof(float));
+    if ((config->theMode >= 0) && (config->theMode < (int)(sizeof(zoomSpeedRows)/sizeof(zoomSpeedRows[0]))))
+        speedRow = zoomSpeedRows[(int)config->theMode];
     
-    /* Noise */
-    if (data->noisify)
     {
-        vx += (((float)random()) / ((float)RAND_MAX) - 0.5f) / 50.0f;
-        vy += (((float)random()) / ((float)RAND_MAX) - 0.5f) / 50.0f;
+        float Xc = - ((float)config->middleX) * ratio;
+        for (x = 0; x < n; x++) {
+            X[x] = Xc;
+            Xc += ratio;
+            /* Hypercos */
+            if (config->hypercosEffect)
+                addY[x] += sin(X[x]*10.0f)/120.0f;
+            /* V Plane */
+            if (config->vPlaneEffect)
+                addY[x] += X[x] * 0.0025f * config->vPlaneEffect;
+        }
     }
     
-    /* Hypercos */
-    if (data->hypercosEffect)
-    {
-        vx += sin(Y*10.0f)/120.0f;
-        vy += sin(X*10.0f)/120.0f;
+    for (y = 0; y < config->prevY; y++) {
+        // Y position of the pixel to compute in normalized coordinates
+        float Y = ((float)((int)y - config->middleY)) * ratio;
+        float addX = 0.0f; /* what vx gets from the row effects */
+        gint16 *bx = brut->x + y * config->prevX;
+        gint16 *by = brut->y + y * config->prevX;
+        
+        /* Hypercos */
+        if (config->hypercosEffect)
+            addX += sin(Y*10.0f)/120.0f;
+        /* H Plane */
+        if (config->hPlaneEffect)
+            addX += Y * 0.0025f * config->hPlaneEffect;
+        
+        /* Noise : 16 bits of the hash for each direction */
+        if (config->noisify) {
+            guint32 pos = y * config->prevX;
+            for (x = 0; x < config->prevX; x++) {
+                guint32 h = zoomNoiseHash (pos + x, config->noiseSeed);
+                noiseX[x] = ((float)(int)(h & 0xffff) / 65535.0f - 0.5f) / 50.0f;
+                noiseY[x] = ((float)(int)(h >> 16) / 65535.0f - 0.5f) / 50.0f;
+            }
+        }
+        
+        speedRow (base, Y, X, coef, n);
+        
+        zoomRowPositions (Y, addX, min, inv_ratio, X, addY, coef, noiseX, noiseY, px, py, n);
+        
+        for (x = 0; x < config->prevX; x++) {
+            bx[x] = zoomClamp ((int)px[x] + (int)(config->middleX*BUFFPOINTNB));
+            by[x] = zoomClamp ((int)py[x] + (int)(config->middleY*BUFFPOINTNB));
+        }
     }
+}
+
+/* the cache only knows the maps of the current size, noisify is never cached */
+static int sameZoomMapConfig (const ZoomMapConfig *a, const ZoomMapConfig *b)
+{
+    return (a->prevX == b->prevX) && (a->prevY == b->prevY)
+        && (a->general_speed == b->general_speed) && (a->theMode == b->theMode)
+        && (a->waveEffect == b->waveEffect) && (a->hypercosEffect == b->hypercosEffect)
+        && (a->vPlaneEffect == b->vPlaneEffect) && (a->hPlaneEffect == b->hPlaneEffect)
+        && (a->middleX == b->middleX) && (a->middleY == b->middleY);
+}
+
+static void copyZoomMap (ZoomMap *dest, const ZoomMap *src)
+{
+    memcpy (dest->brut.x, src->brut.x, src->size * sizeof(gint16));
+    memcpy (dest->brut.y, src->brut.y, src->size * sizeof(gint16));
+}
+
+static void dropZoomMapCacheEntry (ZoomFilterFXWrapperData *data, int i)
+{
+    freeZoomMap (data->mapCache[i].map);
+    data->mapCache[i] = data->mapCache[--data->mapCacheSize];
+}
+
+static void flushZoomMapCache (ZoomFilterFXWrapperData *data)
+{
+    while (data->mapCacheSize > 0)
+        dropZoomMapCacheEntry (data, 0);
+}
+
+/* copies the map of config in dest if it is in the cache */
+static int getCachedZoomMap (ZoomFilterFXWrapperData *data, const ZoomMapConfig *config, ZoomMap *dest)
+{
+    int i;
+    for (i = 0; i < data->mapCacheSize; ++i) {
+        if (sameZoomMapConfig (&data->mapCache[i].config, config)) {
+            data->mapCache[i].lastUse = ++data->mapCacheClock;
+            copyZoomMap (dest, data->mapCache[i].map);
+            atomic_fetch_add (&data->mapCacheHits, 1);
+            return 1;
+        }
+    }
+    atomic_fetch_add (&data->mapCacheMisses, 1);
+    return 0;
+}
+
+/* keeps a copy of map, dropping the least recently used ones to stay under cacheBytes.
+ * a map takes a buffer of mapPool whatever its size, so as many maps fit at all sizes */
+static void cacheZoomMap (ZoomFilterFXWrapperData *data, const ZoomMapConfig *config, const ZoomMap *map, int cacheBytes)
+{
+    int mapBytes = (int) goom_pool_buffer_size (data->mapPool);
+    int nbMax = (mapBytes > 0) ? cacheBytes / mapBytes : 0;
+    ZoomMapCacheEntry *entry;
     
-    /* H Plane */
-    if (data->hPlaneEffect) vx += Y * 0.0025f * data->hPlaneEffect;
-    
-    /* V Plane */
-    if (data->vPlaneEffect) vy += X * 0.0025f * data->vPlaneEffect;
+    if (nbMax > ZOOM_MAP_CACHE_MAX)
+        nbMax = ZOOM_MAP_CACHE_MAX;
     
-    /* TODO : Water Mode */
-    //    if (data->waveEffect)
-
-    vecteur.x = vx;
-    vecteur.y = vy;
+    while ((data->mapCacheSize > 0) && (data->mapCacheSize >= nbMax)) {
+        int i, lru = 0;
+        for (i = 1; i < data->mapCacheSize; ++i)
+            if (data->mapCache[i].lastUse < data->mapCache[lru].lastUse)
+                lru = i;
+        dropZoomMapCacheEntry (data, lru);
+    }
+    if (nbMax == 0)
+        return;
     
-    return vecteur;
+    entry = &data->mapCache[data->mapCacheSize++];
+    entry->config = *config;
+    entry->map = newZoomMap (data->mapPool, map->size);
+    entry->lastUse = ++data->mapCacheClock;
+    copyZoomMap (entry->map, map);
 }
 
+/* by the render thread, once it does not read map anymore */
+static void giveZoomMapBack (ZoomFilterFXWrapperData *data, ZoomMap *map)
+{
+#ifndef _WIN32PC
+    pthread_mutex_lock (&data->mapLock);
+    atomic_store (&data->spareMap, map);
+    pthread_cond_signal (&data->mapGiven);
+    pthread_mutex_unlock (&data->mapLock);
+#else
+    atomic_store (&data->spareMap, map);
+#endif
+}
 
 /*
- * Makes a stripe of a transform buffer (brutT)
+ * Background task : makes the map of a new config, then publishes it in nextMap.
  *
- * The transform is (in order) :
- * Translation (-data->middleX, -data->middleY)
- * Homothetie (Center : 0,0   Coeff : 2/data->prevX)
+ * The render thread only takes it with a pointer swap (cf zoomFilterFastRGB)
+ * and gives its old map back in spareMap.
  */
-static void makeZoomBufferStripe(ZoomFilterFXWrapperData * data, int INTERLACE_INCR)
+static void generateZoomMap (void *arg, const void *request)
 {
-    // Position of the pixel to compute in pixmap coordinates
-    Uint x, y;
-    // Where (verticaly) to stop generating the buffer stripe
-    int maxEnd = (data->interlace_start + INTERLACE_INCR);
-    // Ratio from pixmap to normalized coordinates
-    float ratio = 2.0f/((float)data->prevX);
-    // Ratio from normalized to virtual pixmap coordinates
-    float inv_ratio = BUFFPOINTNBF/ratio;
-    float min = ratio/BUFFPOINTNBF;
-    // Y position of the pixel to compute in normalized coordinates
-    float Y = ((float)(data->interlace_start - data->middleY)) * ratio;
-    
-    maxEnd = data->prevY;
-    if (maxEnd > (data->interlace_start + INTERLACE_INCR))
-        maxEnd = (data->interlace_start + INTERLACE_INCR);
-    
-    for (y = data->interlace_start; (y < data->prevY) && ((signed int)y<maxEnd); y++) {
-        Uint premul_y_prevX = y * data->prevX * 2;
-        float X = - ((float)data->middleX) * ratio;
-        for (x = 0; x < data->prevX; x++)
-        {
-            v2g vector = zoomVector (data, X, Y);
-            
-            /* Finish and avoid null displacement */
-            if (fabs(vector.x) < min) vector.x = (vector.x < 0.0f) ? -min : min;
-            if (fabs(vector.y) < min) vector.y = (vector.y < 0.0f) ? -min : min;
-            
-            data->brutT[premul_y_prevX] = ((int)((X-vector.x)*inv_ratio)+((int)(data->middleX*BUFFPOINTNB)));
-            data->brutT[premul_y_prevX+1] = ((int)((Y-vector.y)*inv_ratio)+((int)(data->middleY*BUFFPOINTNB)));
-            premul_y_prevX += 2;
-            X += ratio;
-        }
-        Y += ratio;
+    ZoomFilterFXWrapperData *data = (ZoomFilterFXWrapperData*)arg;
+    const ZoomMapRequest *req = (const ZoomMapRequest*)request;
+    ZoomMap *map;
+#ifdef GOOM_PROFILE
+    unsigned long long start = goom_profile_now ();
+#endif
+    
+    /* a free map, or the last one if the render thread did not take it: the latest config wins */
+#ifndef _WIN32PC
+    pthread_mutex_lock (&data->mapLock);
+#endif
+    while (1) {
+        map = atomic_exchange (&data->spareMap, NULL);
+        if (map) break;
+        map = atomic_exchange (&data->nextMap, NULL);
+        if (map) break;
+        /* the render thread took the last one, its old map comes back after the blend */
+#ifndef _WIN32PC
+        pthread_cond_wait (&data->mapGiven, &data->mapLock);
+#endif
     }
-    data->interlace_start += INTERLACE_INCR;
-    if (y >= data->prevY-1) data->interlace_start = -1;
+#ifndef _WIN32PC
+    pthread_mutex_unlock (&data->mapLock);
+#endif
+    if (req->config.noisify)
+        makeZoomBuffer (&req->config, &map->brut, data->rows[1]);
+    else if (!getCachedZoomMap (data, &req->config, map)) {
+        makeZoomBuffer (&req->config, &map->brut, data->rows[1]);
+        cacheZoomMap (data, &req->config, map, req->cacheBytes);
+    }
+    
+    atomic_store (&data->nextMap, map);
+#ifdef GOOM_PROFILE
+    goom_profile_event (data->profile, GOOM_STAGE_ZOOM_MAP, start);
+#endif
 }
 
 
@@ -400,32 +711,28 @@ static void makeZoomBufferStripe(ZoomFilterFXWrapperData * data, int INTERLACE_I
 
 
 
-static void c_zoom (Pixel *expix1, Pixel *expix2, unsigned int prevX, unsigned int prevY, signed int *brutS, signed int *brutD,
-                    int buffratio, int precalCoef[16][16])
+static void c_zoom (Pixel *expix1, Pixel *expix2, unsigned int prevX, unsigned int prevY, int start, int end,
+                    const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16])
 {
-    int     myPos, myPos2;
+    int     myPos;
     Color   couleur;
     
     unsigned int ax = (prevX - 1) << PERTEDEC, ay = (prevY - 1) << PERTEDEC;
     
-    int     bufsize = prevX * prevY * 2;
+    int     bufend = end;
     int     bufwidth = prevX;
     
-    expix1[0].val=expix1[prevX-1].val=expix1[prevX*prevY-1].val=expix1[prevX*prevY-prevX].val=0;
-    
-    for (myPos = 0; myPos < bufsize; myPos += 2) {
+    for (myPos = start; myPos < bufend; myPos++) {
         Color   col1, col2, col3, col4;
         int     c1, c2, c3, c4, px, py;
         int     pos;
         int     coeffs;
         
-        int     brutSmypos = brutS[myPos];
-        
-        myPos2 = myPos + 1;
+        int     brutSmypos = brutS->x[myPos];
         
-        px = brutSmypos + (((brutD[myPos] - brutSmypos) * buffratio) >> BUFFPOINTNB);
-        brutSmypos = brutS[myPos2];
-        py = brutSmypos + (((brutD[myPos2] - brutSmypos) * buffratio) >> BUFFPOINTNB);
+        px = brutSmypos + (((brutD->x[myPos] - brutSmypos) * buffratio) >> BUFFPOINTNB);
+        brutSmypos = brutS->y[myPos];
+        py = brutSmypos + (((brutD->y[myPos] - brutSmypos) * buffratio) >> BUFFPOINTNB);
         
         if ((py >= ay) || (px >= ax)) {
             pos = coeffs = 0;
@@ -460,7 +767,51 @@ static void c_zoom (Pixel *expix1, Pixel *expix2, unsigned int prevX, unsigned i
             couleur.b -= 5;
         couleur.b >>= 8;
         
-        setPixelRGB_ (expix2, myPos >> 1, couleur);
+        setPixelRGB_ (expix2, myPos, couleur);
+    }
+}
+
+/* c_zoom without the interpolation of the positions, see makeSteadyZoom */
+static void c_zoom_steady (Pixel *expix1, Pixel *expix2, unsigned int prevX, int start, int end,
+                           const guint32 *steady, const int coefs[ZOOM_STEADY_NB_COEFS])
+{
+    int     myPos;
+    Color   couleur;
+    
+    int     bufwidth = prevX;
+    
+    for (myPos = start; myPos < end; myPos++) {
+        Color   col1, col2, col3, col4;
+        int     c1, c2, c3, c4;
+        int     pos = steady[myPos] >> ZOOM_STEADY_COEF_BITS;
+        
+        getPixelRGB_ (expix1, pos, &col1);
+        getPixelRGB_ (expix1, pos + 1, &col2);
+        getPixelRGB_ (expix1, pos + bufwidth, &col3);
+        getPixelRGB_ (expix1, pos + bufwidth + 1, &col4);
+        
+        c1 = coefs[steady[myPos] & ZOOM_STEADY_COEF_MASK];
+        c2 = (c1 >> 8) & 0xFF;
+        c3 = (c1 >> 16) & 0xFF;
+        c4 = (c1 >> 24) & 0xFF;
+        c1 = c1 & 0xff;
+        
+        couleur.r = col1.r * c1 + col2.r * c2 + col3.r * c3 + col4.r * c4;
+        if (couleur.r > 5)
+            couleur.r -= 5;
+        couleur.r >>= 8;
+        
+        couleur.v = col1.v * c1 + col2.v * c2 + col3.v * c3 + col4.v * c4;
+        if (couleur.v > 5)
+            couleur.v -= 5;
+        couleur.v >>= 8;
+        
+        couleur.b = col1.b * c1 + col2.b * c2 + col3.b * c3 + col4.b * c4;
+        if (couleur.b > 5)
+            couleur.b -= 5;
+        couleur.b >>= 8;
+        
+        setPixelRGB_ (expix2, myPos, couleur);
     }
 }
 
@@ -508,6 +859,170 @@ static void generateTheWaterFXHorizontalDirectionBuffer(PluginInfo *goomInfo, Zo
 
 
 
+/* collapses brutS and mapD for the pixels [start..end[, like c_zoom computes them */
+static void makeSteadyZoom (ZoomFilterFXWrapperData *data, int start, int end)
+{
+    const ZoomTransform *brutS = &data->brutS;
+    const ZoomTransform *brutD = &data->mapD->brut;
+    unsigned int ax = (data->prevX - 1) << PERTEDEC, ay = (data->prevY - 1) << PERTEDEC;
+    int myPos;
+    
+    for (myPos = start; myPos < end; myPos++) {
+        int px = brutS->x[myPos] + (((brutD->x[myPos] - brutS->x[myPos]) * data->buffratio) >> BUFFPOINTNB);
+        int py = brutS->y[myPos] + (((brutD->y[myPos] - brutS->y[myPos]) * data->buffratio) >> BUFFPOINTNB);
+        
+        if (((unsigned int)py >= ay) || ((unsigned int)px >= ax))
+            data->steady[myPos] = ZOOM_STEADY_NO_COEF;
+        else
+            data->steady[myPos] = (((px >> PERTEDEC) + data->prevX * (py >> PERTEDEC)) << ZOOM_STEADY_COEF_BITS)
+                                | ((px & PERTEMASK) << PERTEDEC) | (py & PERTEMASK);
+    }
+}
+
+/* zooms the pixels [start..end[ with the method of the frame */
+static inline void zoomRun (ZoomFilterFXWrapperData *data, int start, int end)
+{
+    if (data->useSteady)
+        data->goomInfo->methods.zoom_filter_steady (data->prevX, start, end, data->src, data->dest,
+                                                    data->steady, data->steadyCoefs);
+    else if (BVAL(data->exact_bp) || data->goomInfo->deterministic)
+        data->goomInfo->methods.zoom_filter_exact (data->prevX, data->prevY, start, end, data->src, data->dest,
+                                                   &data->brutS, &data->mapD->brut, data->buffratio, data->precalCoef);
+    else
+        data->goomInfo->methods.zoom_filter (data->prevX, data->prevY, start, end, data->src, data->dest,
+                                             &data->brutS, &data->mapD->brut, data->buffratio, data->precalCoef);
+}
+
+/** zoom the lines of one band, see zoomFilterFastRGB */
+static void zoomFilterBand (void *arg, int band, int nbBands)
+{
+    ZoomFilterFXWrapperData *data = (ZoomFilterFXWrapperData*)arg;
+    
+    int prevX = data->prevX;
+    int yStart = (data->prevY * band) / nbBands;
+    int yEnd = (data->prevY * (band + 1)) / nbBands;
+    int tileW = IVAL(data->tile_width_p);
+    int tileH = IVAL(data->tile_height_p);
+    int x, y, tx, ty;
+    
+    /* each band collapses its own pixels */
+    if (data->useSteady && !data->steadyValid)
+        makeSteadyZoom (data, yStart * prevX, yEnd * prevX);
+    
+    if (!BVAL(data->tiled_bp) || (tileW <= 0) || (tileH <= 0) || (tileW >= prevX))
+        zoomRun (data, yStart * prevX, yEnd * prevX);
+    else {
+        /* tile by tile, each line of a tile is a run of the zoom.
+         * the result does not depend on the order, each pixel is computed alone. */
+        for (ty = yStart; ty < yEnd; ty += tileH) {
+            int tyEnd = (ty + tileH < yEnd) ? ty + tileH : yEnd;
+            for (tx = 0; tx < prevX; tx += tileW) {
+                int txEnd = (tx + tileW < prevX) ? tx + tileW : prevX;
+                for (y = ty; y < tyEnd; y++) {
+                    x = y * prevX;
+                    zoomRun (data, x + tx, x + txEnd);
+                }
+            }
+        }
+    }
+    
+    /* the source lines of the band are still in the cache */
+    if (data->bandHook)
+        data->bandHook (data->goomInfo, yStart, yEnd);
+}
+
+/* seconds, only used to compare durations */
+static double zoomClock (void)
+{
+    struct timespec t;
+    timespec_get (&t, TIME_UTC);
+    return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+/* bands of the zoom of height lines */
+static int zoomBands (PluginInfo *goomInfo, Uint height)
+{
+    int nbBands = goom_thread_pool_size(goomInfo->threads);
+    if (nbBands > 1)
+        nbBands *= ZOOM_BANDS_PER_THREAD;
+    if (nbBands > (int)height / ZOOM_BAND_MIN_LINES)
+        nbBands = height / ZOOM_BAND_MIN_LINES;
+    if (nbBands < 1)
+        nbBands = 1;
+    return nbBands;
+}
+
+/*
+ * Chooses the tile size of the zoom : times the zoom of a strong map
+ * (AMULETTE_MODE) with each of zoomTileSizes, keeps the fastest.
+ * Done once for a goom, at the size of goom_init, whatever the size it has then :
+ * the sizes after are not slowed down by it. The zoom reads src (a screen buffer,
+ * of goom_init's size at least) and writes in steady, the frame is not touched.
+ */
+static void tuneZoomTiles (PluginInfo *goomInfo, ZoomFilterFXWrapperData *data)
+{
+    ZoomMapConfig config = data->config;
+    ZoomMap *map = newZoomMap (data->mapPool, data->initX * data->initY);
+    ZoomMap *mapD = data->mapD;
+    ZoomTransform brutS = data->brutS;
+    Pixel *dest = data->dest;
+    Uint prevX = data->prevX, prevY = data->prevY;
+    int buffratio = data->buffratio;
+    int useSteady = data->useSteady;
+    int nbBands = zoomBands (goomInfo, data->initY);
+    double best = 0.0;
+    int i, pass, bestW = 0, bestH = 0;
+    
+    /* no noise, random() must not see this */
+    config.theMode = AMULETTE_MODE;
+    config.noisify = 0;
+    config.prevX = data->initX;
+    config.prevY = data->initY;
+    config.middleX = data->initX / 2;
+    config.middleY = data->initY / 2;
+    makeZoomBuffer (&config, &map->brut, data->rows[0]);
+    data->prevX = data->initX;
+    data->prevY = data->initY;
+    data->brutS = map->brut;
+    data->mapD = map;
+    data->dest = (Pixel *) data->steady;
+    data->buffratio = 0;
+    data->useSteady = 0;
+    
+    /* the first one must not pay for the cold caches */
+    goom_thread_pool_run (goomInfo->threads, nbBands, zoomFilterBand, data);
+    
+    for (i = 0; i < (int)(sizeof(zoomTileSizes)/sizeof(zoomTileSizes[0])); ++i) {
+        IVAL(data->tile_width_p) = zoomTileSizes[i][0];
+        IVAL(data->tile_height_p) = zoomTileSizes[i][1];
+        for (pass = 0; pass < ZOOM_TILE_TUNE_PASSES; ++pass) {
+            double t = zoomClock ();
+            goom_thread_pool_run (goomInfo->threads, nbBands, zoomFilterBand, data);
+            t = zoomClock () - t;
+            if ((best == 0.0) || (t < best)) {
+                best = t;
+                bestW = zoomTileSizes[i][0];
+                bestH = zoomTileSizes[i][1];
+            }
+        }
+    }
+    
+    data->prevX = prevX;
+    data->prevY = prevY;
+    data->brutS = brutS;
+    data->mapD = mapD;
+    data->dest = dest;
+    data->buffratio = buffratio;
+    data->useSteady = useSteady;
+    data->steadyValid = 0;
+    freeZoomMap (map);
+    
+    IVAL(data->tile_width_p) = bestW;
+    data->tile_width_p.change_listener (&data->tile_width_p);
+    IVAL(data->tile_height_p) = bestH;
+    data->tile_height_p.change_listener (&data->tile_height_p);
+}
+
 /**
 * Main work for the dynamic displacement map.
  * 
@@ -531,100 +1046,142 @@ void zoomFilterFastRGB (PluginInfo *goomInfo, Pixel * pix1, Pixel * pix2, ZoomFi
     
     /** changement de taille **/
     if ((data->prevX != resx) || (data->prevY != resy)) {
-        data->prevX = resx;
-        data->prevY = resy;
-        
-        if (data->brutS) free (data->freebrutS);
-        data->brutS = 0;
-        if (data->brutD) free (data->freebrutD);
-        data->brutD = 0;
-        if (data->brutT) free (data->freebrutT);
-        data->brutT = 0;
-        
-        data->middleX = resx / 2;
-        data->middleY = resy / 2;
+        /* the background generation works on the old size */
+        goom_background_task_wait (data->mapTask);
+        
+        data->prevX = data->config.prevX = resx;
+        data->prevY = data->config.prevY = resy;
+        
+        data->steadyValid = 0;
+        if ((resx * resy > data->bufferSize) || (resx > data->bufferWidth)) {
+            /* the old buffers stay in the arena until goom_close, this is the biggest size so far */
+            freeZoomMap (data->mapS);
+            data->mapS = 0;
+            data->brutS.x = data->brutS.y = 0;
+            data->steady = 0;
+            freeZoomMap (data->mapD);
+            data->mapD = 0;
+            freeZoomMap (atomic_exchange (&data->nextMap, NULL));
+            freeZoomMap (atomic_exchange (&data->spareMap, NULL));
+            data->bufferSize = 0;
+        }
+        else {
+            /* the buffers are big enough, the map not used yet is of the old size */
+            ZoomMap *spare = atomic_exchange (&data->nextMap, NULL);
+            if (spare == NULL)
+                spare = atomic_exchange (&data->spareMap, NULL);
+            spare->size = data->mapD->size = data->mapS->size = resx * resy;
+            atomic_store (&data->spareMap, spare);
+        }
+        flushZoomMapCache (data);
+        
+        data->config.middleX = resx / 2;
+        data->config.middleY = resy / 2;
         data->mustInitBuffers = 1;
         if (data->firedec) free (data->firedec);
         data->firedec = 0;
     }
     
-    if (data->interlace_start != -2)
-        zf = NULL;
-    
     /** changement de config **/
     if (zf) {
         data->reverse = zf->reverse;
-        data->general_speed = (float)(zf->vitesse-128)/128.0f;
-        if (data->reverse) data->general_speed = -data->general_speed;
-        data->middleX = zf->middleX;
-        data->middleY = zf->middleY;
-        data->theMode = zf->mode;
-        data->hPlaneEffect = zf->hPlaneEffect;
-        data->vPlaneEffect = zf->vPlaneEffect;
-        data->waveEffect = zf->waveEffect;
-        data->hypercosEffect = zf->hypercosEffect;
-        data->noisify = zf->noisify;
-        data->interlace_start = 0;
+        data->config.general_speed = (float)(zf->vitesse-128)/128.0f;
+        if (data->reverse) data->config.general_speed = -data->config.general_speed;
+        data->config.middleX = zf->middleX;
+        data->config.middleY = zf->middleY;
+        data->config.theMode = zf->mode;
+        data->config.hPlaneEffect = zf->hPlaneEffect;
+        data->config.vPlaneEffect = zf->vPlaneEffect;
+        data->config.waveEffect = zf->waveEffect;
+        data->config.hypercosEffect = zf->hypercosEffect;
+        data->config.noisify = zf->noisify;
+        if (data->config.noisify)
+            data->config.noiseSeed = goom_random (goomInfo->gRandom);
     }
     
-    
     if (data->mustInitBuffers) {
         
         data->mustInitBuffers = 0;
-        data->freebrutS = (signed int *) calloc (resx * resy * 2 + 128, sizeof(unsigned int));
-        data->brutS = (gint32 *) ((1 + ((uintptr_t) (data->freebrutS)) / 128) * 128);
-        
-        data->freebrutD = (signed int *) calloc (resx * resy * 2 + 128, sizeof(unsigned int));
-        data->brutD = (gint32 *) ((1 + ((uintptr_t) (data->freebrutD)) / 128) * 128);
-        
-        data->freebrutT = (signed int *) calloc (resx * resy * 2 + 128, sizeof(unsigned int));
-        data->brutT = (gint32 *) ((1 + ((uintptr_t) (data->freebrutT)) / 128) * 128);
+        if (data->bufferSize == 0) {
+            /* source, dest, spare, tuning, and the cache : no allocation anymore after this.
+             * big enough for goom_init's size, whatever the size goom starts at */
+            Uint size = (resx * resy > data->initX * data->initY) ? resx * resy : data->initX * data->initY;
+            Uint width = (resx > data->initX) ? resx : data->initX;
+            int nbCached;
+            Uint n = (width + ZOOM_ROW_BLOCK - 1) & ~(ZOOM_ROW_BLOCK - 1);
+            
+            data->bufferSize = size;
+            data->bufferWidth = width;
+            data->mapPool = newZoomMapPool (goomInfo->arena, size);
+            nbCached = IVAL(data->cache_size_p) * 1024 * 1024 / (int) goom_pool_buffer_size (data->mapPool);
+            goom_pool_reserve (data->mapPool, 4 + ((nbCached < ZOOM_MAP_CACHE_MAX) ? nbCached : ZOOM_MAP_CACHE_MAX));
+            data->mapS = newZoomMap (data->mapPool, resx * resy);
+            data->brutS = data->mapS->brut;
+            data->mapD = newZoomMap (data->mapPool, resx * resy);
+            atomic_store (&data->spareMap, newZoomMap (data->mapPool, resx * resy));
+            data->steady = (guint32 *) goom_arena_alloc (goomInfo->arena, size * sizeof(guint32));
+            data->rows[0] = (float *) goom_arena_alloc (goomInfo->arena, 7 * n * sizeof(float));
+            data->rows[1] = (float *) goom_arena_alloc (goomInfo->arena, 7 * n * sizeof(float));
+        }
+        data->steadyValid = 0;
+        data->lastBuffratio = -1;
         
         data->buffratio = 0;
         
         data->firedec = (int *) malloc (data->prevY * sizeof (int));
         generateTheWaterFXHorizontalDirectionBuffer(goomInfo, data);
         
-        data->interlace_start = 0;
-        makeZoomBufferStripe(data,resy);
+        /* the first map is needed right now */
+        makeZoomBuffer(&data->config, &data->mapD->brut, data->rows[0]);
         
-        /* Copy the data from temp to dest and source */
-        memcpy(data->brutS,data->brutT,resx * resy * 2 * sizeof(int));
-        memcpy(data->brutD,data->brutT,resx * resy * 2 * sizeof(int));
+        /* Copy the data from dest to source */
+        memcpy(data->brutS.x,data->mapD->brut.x,resx * resy * sizeof(gint16));
+        memcpy(data->brutS.y,data->mapD->brut.y,resx * resy * sizeof(gint16));
     }
-    
-    /* generation du buffer de trans */
-    if (data->interlace_start == -1) {
-        
-        /* sauvegarde de l'etat actuel dans la nouvelle source
-        * TODO: write that in MMX (has been done in previous version, but did not follow some new fonctionnalities) */
-        y = data->prevX * data->prevY * 2;
-        for (x = 0; x < y; x += 2) {
-            int brutSmypos = data->brutS[x];
-            int x2 = x + 1;
-            
-            data->brutS[x] = brutSmypos + (((data->brutD[x] - brutSmypos) * data->buffratio) >> BUFFPOINTNB);
-            brutSmypos = data->brutS[x2];
-            data->brutS[x2] = brutSmypos + (((data->brutD[x2] - brutSmypos) * data->buffratio) >> BUFFPOINTNB);
-        }
-        data->buffratio = 0;
+    else if (zf) {
+        /* creation de la nouvelle destination, en tache de fond */
+        ZoomMapRequest req;
+        req.config = data->config;
+        req.cacheBytes = IVAL(data->cache_size_p) * 1024 * 1024;
+        goom_background_task_post (data->mapTask, &req);
+        /* taken below, not whenever it is ready */
+        if (goomInfo->deterministic)
+            goom_background_task_wait (data->mapTask);
     }
     
-    if (data->interlace_start == -1) {
-        signed int * tmp;
-        tmp = data->brutD;
-        data->brutD=data->brutT;
-        data->brutT=tmp;
-        tmp = data->freebrutD;
-        data->freebrutD=data->freebrutT;
-        data->freebrutT=tmp;
-        data->interlace_start = -2;
+    /* counted by the background generation */
+    if (IVAL(data->cache_hits_p) != atomic_load (&data->mapCacheHits)) {
+        IVAL(data->cache_hits_p) = atomic_load (&data->mapCacheHits);
+        data->cache_hits_p.change_listener (&data->cache_hits_p);
+    }
+    if (IVAL(data->cache_misses_p) != atomic_load (&data->mapCacheMisses)) {
+        IVAL(data->cache_misses_p) = atomic_load (&data->mapCacheMisses);
+        data->cache_misses_p.change_listener (&data->cache_misses_p);
     }
     
-    if (data->interlace_start>=0)
+    /* la nouvelle destination est prete */
     {
-        /* creation de la nouvelle destination */
-        makeZoomBufferStripe(data,resy/16);
+        ZoomMap *next = atomic_exchange (&data->nextMap, NULL);
+        
+        if (next != NULL) {
+            /* sauvegarde de l'etat actuel dans la nouvelle source
+             * TODO: write that in MMX (has been done in previous version, but did not follow some new fonctionnalities) */
+            ZoomTransform *brutD = &data->mapD->brut;
+            y = data->prevX * data->prevY;
+            for (x = 0; x < y; x++) {
+                /* toujours entre S et D, pas besoin de saturer */
+                int brutSmypos = data->brutS.x[x];
+                data->brutS.x[x] = brutSmypos + (((brutD->x[x] - brutSmypos) * data->buffratio) >> BUFFPOINTNB);
+                brutSmypos = data->brutS.y[x];
+                data->brutS.y[x] = brutSmypos + (((brutD->y[x] - brutSmypos) * data->buffratio) >> BUFFPOINTNB);
+            }
+            data->buffratio = 0;
+            
+            giveZoomMapBack (data, data->mapD);
+            data->mapD = next;
+            data->steadyValid = 0;
+            data->lastBuffratio = -1;
+        }
     }
     
     if (switchIncr != 0) {
@@ -640,8 +1197,37 @@ void zoomFilterFastRGB (PluginInfo *goomInfo, Pixel * pix1, Pixel * pix2, ZoomFi
     
     data->zoom_width = data->prevX;
     
-    goomInfo->methods.zoom_filter (data->prevX, data->prevY, pix1, pix2,
-                                   data->brutS, data->brutD, data->buffratio, data->precalCoef);
+    /* regime etabli : most of the time buffratio stays at BUFFPOINTMASK once a transition is over.
+     * the transforms are then collapsed by the bands of the first frame, the next ones
+     * do not interpolate anymore. */
+    if (data->buffratio != data->lastBuffratio)
+        data->steadyValid = 0;
+    data->useSteady = (data->buffratio == data->lastBuffratio);
+    data->lastBuffratio = data->buffratio;
+    
+    /* each destination pixel only depends on brutS, brutD and the source,
+     * so the destination is split in bands of lines, zoomed in parallel. */
+    {
+        int nbBands = zoomBands (goomInfo, data->prevY);
+        
+        /* the corners are read by all the bands, clear them before */
+        pix1[0].val = pix1[data->prevX-1].val = pix1[data->prevX*data->prevY-1].val = pix1[data->prevX*data->prevY-data->prevX].val = 0;
+        
+        data->goomInfo = goomInfo;
+        data->src = pix1;
+        data->dest = pix2;
+        
+        if (BVAL(data->tiled_bp) && data->mustTuneTiles) {
+            data->mustTuneTiles = 0;
+            tuneZoomTiles (goomInfo, data);
+        }
+        data->bandHook = goomInfo->zoomBandHook;
+        goomInfo->zoomBandHook = NULL;
+        goom_thread_pool_run (goomInfo->threads, nbBands, zoomFilterBand, data);
+        data->bandHook = NULL;
+        if (data->useSteady)
+            data->steadyValid = 1;
+    }
 }
 
 static void generatePrecalCoef (int precalCoef[16][16])
@@ -690,26 +1276,45 @@ static void zoomFilterVisualFXWrapper_init (struct _VISUAL_FX *_this, PluginInfo
     
     data->coeffs = 0;
     data->freecoeffs = 0;
-    data->brutS = 0;
-    data->freebrutS = 0;
-    data->brutD = 0;
-    data->freebrutD = 0;
-    data->brutT = 0;
-    data->freebrutT = 0;
-    data->prevX = 0;
-    data->prevY = 0;
+    data->brutS.x = data->brutS.y = 0;
+    data->mapS = 0;
+    data->mapD = 0;
+    data->mapPool = 0;
+    data->bufferSize = data->bufferWidth = 0;
+    data->rows[0] = data->rows[1] = 0;
+    data->initX = info->screen.width;
+    data->initY = info->screen.height;
+    atomic_init (&data->nextMap, NULL);
+    atomic_init (&data->spareMap, NULL);
+#ifndef _WIN32PC
+    pthread_mutex_init (&data->mapLock, NULL);
+    pthread_cond_init (&data->mapGiven, NULL);
+#endif
+    data->mapTask = goom_background_task_new (generateZoomMap, data, sizeof(ZoomMapRequest));
+    data->mapCacheSize = 0;
+    data->mapCacheClock = 0;
+    atomic_init (&data->mapCacheHits, 0);
+    atomic_init (&data->mapCacheMisses, 0);
+    data->profile = info->profile;
+    data->prevX = data->config.prevX = 0;
+    data->prevY = data->config.prevY = 0;
     
     data->mustInitBuffers = 1;
-    data->interlace_start = -2;
+    data->mustTuneTiles = 1; /* once, cf tuneZoomTiles */
+    data->steady = 0;
+    data->steadyValid = data->useSteady = 0;
+    data->lastBuffratio = -1;
     
-    data->general_speed = 0.0f;
     data->reverse = 0;
-    data->theMode = AMULETTE_MODE;
-    data->waveEffect = 0;
-    data->hypercosEffect = 0;
-    data->vPlaneEffect = 0;
-    data->hPlaneEffect = 0;
-    data->noisify = 2;
+    data->config.general_speed = 0.0f;
+    data->config.theMode = AMULETTE_MODE;
+    data->config.waveEffect = 0;
+    data->config.hypercosEffect = 0;
+    data->config.vPlaneEffect = 0;
+    data->config.hPlaneEffect = 0;
+    data->config.noisify = 2;
+    data->config.noiseSeed = 0;
+    data->config.middleX = data->config.middleY = 0;
     
     /** modif by jeko : fixedpoint : buffration = (16:16) (donc 0<=buffration<=2^16) */
     data->buffratio = 0;
@@ -717,24 +1322,72 @@ static void zoomFilterVisualFXWrapper_init (struct _VISUAL_FX *_this, PluginInfo
     
     data->wave = data->wavesp = 0;
     
+    data->goomInfo = info;
+    data->src = data->dest = 0;
+    data->bandHook = NULL;
+    
     data->enabled_bp = secure_b_param("Enabled", 1);
+    data->exact_bp = secure_b_param("Bit Exact", 0);
+    
+    data->cache_size_p = secure_i_param("Map Cache Size (MB)");
+    IVAL(data->cache_size_p) = 32;
+    IMIN(data->cache_size_p) = 0;
+    IMAX(data->cache_size_p) = 512;
+    ISTEP(data->cache_size_p) = 8;
+    
+    data->cache_hits_p = secure_i_feedback("Map Cache Hits");
+    IVAL(data->cache_hits_p) = 0;
+    IMAX(data->cache_hits_p) = INT_MAX;
+    data->cache_misses_p = secure_i_feedback("Map Cache Misses");
+    IVAL(data->cache_misses_p) = 0;
+    IMAX(data->cache_misses_p) = INT_MAX;
+    
+    data->tiled_bp = secure_b_param("Tiled", 1);
+    data->tile_width_p = secure_i_param("Tile Width");
+    IVAL(data->tile_width_p) = 0;
+    IMIN(data->tile_width_p) = 0;
+    IMAX(data->tile_width_p) = ZOOM_MAX_SIZE;
+    ISTEP(data->tile_width_p) = 8;
+    data->tile_height_p = secure_i_param("Tile Height");
+    IVAL(data->tile_height_p) = 0;
+    IMIN(data->tile_height_p) = 0;
+    IMAX(data->tile_height_p) = ZOOM_MAX_SIZE;
+    ISTEP(data->tile_height_p) = 8;
     
-    data->params = plugin_parameters ("Zoom Filter", 1);
+    data->params = plugin_parameters ("Zoom Filter", 10);
     data->params.params[0] = &data->enabled_bp;
+    data->params.params[1] = &data->exact_bp;
+    data->params.params[2] = 0;
+    data->params.params[3] = &data->cache_size_p;
+    data->params.params[4] = &data->cache_hits_p;
+    data->params.params[5] = &data->cache_misses_p;
+    data->params.params[6] = 0;
+    data->params.params[7] = &data->tiled_bp;
+    data->params.params[8] = &data->tile_width_p;
+    data->params.params[9] = &data->tile_height_p;
     
     _this->params = &data->params;
     _this->fx_data = (void*)data;
     
     /** modif d'optim by Jeko : precalcul des 4 coefs resultant des 2 pos */
     generatePrecalCoef(data->precalCoef);
+    memcpy (data->steadyCoefs, data->precalCoef, sizeof(data->precalCoef));
+    data->steadyCoefs[ZOOM_STEADY_NO_COEF] = 0;
 }
 
 static void zoomFilterVisualFXWrapper_free (struct _VISUAL_FX *_this)
 {
     ZoomFilterFXWrapperData *data = (ZoomFilterFXWrapperData*)_this->fx_data;
-    free (data->freebrutS);
-    free (data->freebrutD);
-    free (data->freebrutT);
+    goom_background_task_free (data->mapTask);
+#ifndef _WIN32PC
+    pthread_cond_destroy (&data->mapGiven);
+    pthread_mutex_destroy (&data->mapLock);
+#endif
+    flushZoomMapCache (data);
+    freeZoomMap (data->mapS);
+    freeZoomMap (data->mapD);
+    freeZoomMap (atomic_load (&data->nextMap));
+    freeZoomMap (atomic_load (&data->spareMap));
     free (data->firedec);
     free (data->params.params);
     free(_this->fx_data);
@@ -285,11 +285,17 @@ static void fs_apply(VisualFX *_this, Pixel *src, Pixel *dest, PluginInfo *info)
 				(int)(data->stars[i].y-data->stars[i].vy*6),
 				col,
 				(int)info->screen.width, (int)info->screen.height);
+		plugin_info_overlay_line(info,(int)data->stars[i].x,(int)data->stars[i].y,
+				(int)(data->stars[i].x-data->stars[i].vx*6),
+				(int)(data->stars[i].y-data->stars[i].vy*6));
 		info->methods.draw_line(dest,(int)data->stars[i].x,(int)data->stars[i].y,
 				(int)(data->stars[i].x-data->stars[i].vx*2),
 				(int)(data->stars[i].y-data->stars[i].vy*2),
 				col,
 				(int)info->screen.width, (int)info->screen.height);
+		plugin_info_overlay_line(info,(int)data->stars[i].x,(int)data->stars[i].y,
+				(int)(data->stars[i].x-data->stars[i].vx*2),
+				(int)(data->stars[i].y-data->stars[i].vy*2));
 	}
 
 	/* look for dead particules */
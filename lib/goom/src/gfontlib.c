@@ -1,22 +1,54 @@
 #include "goom_config.h"
 #include "gfontrle.h"
 #include "gfontlib.h"
+#include <stdatomic.h>
 #include <string.h>
 #include <stdlib.h>
 
-static Pixel  ***font_chars;
-static int    *font_width;
-static int    *font_height;
-static Pixel  ***small_font_chars;
-static int    *small_font_width;
-static int    *small_font_height;
+typedef struct {
+	Pixel  ***chars;
+	int    *width;
+	int    *height;
+} GFont;
 
-void gfont_load (void) {
+typedef struct {
+	GFont big;
+	GFont small;
+	unsigned int last; /* chars [33..last[ have their own pixels, the others are those of '*' */
+} GFonts;
+
+/* made by the first gfont_load, then only read : the same for every goom */
+static _Atomic(GFonts *) fonts;
+
+static void free_fonts (GFonts *f) {
+	unsigned int i;
+	int y;
+	for (i=33;i<f->last;i++) {
+		for (y = 0; y < f->big.height[i]; y++)
+			free (f->big.chars[i][y]);
+		for (y = 0; y < f->big.height[i]/2; y++)
+			free (f->small.chars[i][y]);
+		free (f->big.chars[i]);
+		free (f->small.chars[i]);
+	}
+	free (f->big.chars);
+	free (f->big.width);
+	free (f->big.height);
+	free (f->small.chars);
+	free (f->small.width);
+	free (f->small.height);
+	free (f);
+}
+
+static GFonts *make_fonts (void) {
+	GFonts *f;
 	unsigned char *gfont;
 	unsigned int i = 0, j = 0;
 	unsigned int nba = 0;
 	unsigned int current = 32;
         int    *font_pos;
+        Pixel  ***font_chars, ***small_font_chars;
+        int    *font_width, *font_height, *small_font_width, *small_font_height;
 	/* decompress le rle */
 
         
@@ -128,11 +160,46 @@ void gfont_load (void) {
         small_font_chars [32] = 0;
         free( gfont );
         free( font_pos );
+
+	f = malloc (sizeof(GFonts));
+	f->big.chars = font_chars;
+	f->big.width = font_width;
+	f->big.height = font_height;
+	f->small.chars = small_font_chars;
+	f->small.width = small_font_width;
+	f->small.height = small_font_height;
+	f->last = current;
+	return f;
+}
+
+void gfont_load (void) {
+	GFonts *f, *none = NULL;
+
+	if (atomic_load (&fonts) != NULL)
+		return;
+	/* two gooms may make them at the same time, the first one made is kept */
+	f = make_fonts ();
+	if (!atomic_compare_exchange_strong (&fonts, &none, f))
+		free_fonts (f);
+}
+
+int     goom_text_height (void) {
+	const GFonts *f = atomic_load (&fonts);
+	int     c, h = 0;
+
+	/* the small font is half as high */
+	if (f == NULL)
+		return 0;
+	for (c = 0; c < 256; c++)
+		if (f->big.height[c] > h)
+			h = f->big.height[c];
+	return h;
 }
 
 void    goom_draw_text (Pixel * buf,int resolx,int resoly,
 												int x, int y,
 												const char *str, float charspace, int center) {
+	const GFonts *f = atomic_load (&fonts);
 	float   fx = (float) x;
 	int     fin = 0;
 
@@ -140,24 +207,24 @@ void    goom_draw_text (Pixel * buf,int resolx,int resoly,
         int    *cur_font_width;
         int    *cur_font_height;
 
+        if (f == NULL)
+		return ;
+
         if (resolx>320)
         {
             /* printf("use big\n"); */
-            cur_font_chars = font_chars;
-            cur_font_width = font_width;
-            cur_font_height = font_height;
+            cur_font_chars = f->big.chars;
+            cur_font_width = f->big.width;
+            cur_font_height = f->big.height;
         }
         else
         {
             /* printf ("use small\n"); */
-            cur_font_chars = small_font_chars;
-            cur_font_width = small_font_width;
-            cur_font_height = small_font_height;
+            cur_font_chars = f->small.chars;
+            cur_font_width = f->small.width;
+            cur_font_height = f->small.height;
         }
 
-        if (cur_font_chars == NULL)
-		return ;
-
 	if (center) {
 		unsigned char   *tmp = (unsigned char*)str;
 		float   lg = -charspace;
@@ -3,8 +3,11 @@
 
 #include "goom_graphic.h"
 
+/* the fonts are made once, for all the gooms. any thread */
 void gfont_load (void);
 void goom_draw_text (Pixel * buf,int resolx,int resoly, int x, int y,
 		const char *str, float chspace, int center);
+/* a text drawn at y only touches the lines [y - goom_text_height()..y[ */
+int goom_text_height (void);
 
 #endif
@@ -10,8 +10,35 @@
 
 #define NB_FX 10
 
+/* biggest width and height : the zoom keeps its positions on 16 bits (cf ZOOM_MAX_SIZE) */
+#define GOOM_MAX_SIZE 2047
+
+/* NULL if the size is 0 or bigger than GOOM_MAX_SIZE */
 PluginInfo *goom_init (guint32 resx, guint32 resy);
-void goom_set_resolution (PluginInfo *goomInfo, guint32 resx, guint32 resy);
+
+/*
+ * same as goom_init, but every random choice of goom comes from seed : the same
+ * seed and the same sound give the same frames, bit for bit, whatever the SIMD
+ * methods and the number of threads (cf test/goom_golden.c).
+ * slower : the zoom maps are made during goom_update, and the zoom is always the exact one.
+ */
+PluginInfo *goom_init_seeded (guint32 resx, guint32 resy, guint32 seed);
+
+/*
+ * the image goes on at the new size. the buffers are kept while they are big
+ * enough : goom_init at the biggest resolution first, then going down and up
+ * allocates nothing.
+ * a buffer of goom_set_screenbuffer / goom_give_screenbuffer must be set again.
+ * returns 0, the size staying as it was, if it is 0 or bigger than GOOM_MAX_SIZE.
+ */
+int goom_set_resolution (PluginInfo *goomInfo, guint32 resx, guint32 resy);
+
+/*
+ * number of threads used for the full screen effects (zoom filter...)
+ * nbThreads <= 0 : one thread per cpu.
+ * must not be called during a goom_update.
+ */
+void goom_set_threads (PluginInfo *goomInfo, int nbThreads);
 
 /*
  * forceMode == 0 : do nothing
@@ -29,6 +56,92 @@ guint32 *goom_update (PluginInfo *goomInfo,
 /* returns 0 if the buffer wasn't accepted */
 int goom_set_screenbuffer(PluginInfo *goomInfo, void *buffer);
 
+/*
+ * multiplies the brightness of the output : 1 as set (default), 0 black.
+ * with silence and 0, the screen stops changing once the flashes have decayed.
+ */
+void goom_set_fade(PluginInfo *goomInfo, float fade);
+
+/*
+ * screen buffers of the current resolution, aligned for the SIMD methods.
+ * their content is black at first. they can still be used after a
+ * goom_set_resolution to a smaller one, they must be freed before goom_close.
+ * they come from a pool (cf goom_arena.h) : once goom_reserve_screenbuffers made
+ * them, allocating and freeing them again costs nothing.
+ */
+void *goom_alloc_screenbuffer(PluginInfo *goomInfo);
+void goom_free_screenbuffer(void *buffer);
+void goom_reserve_screenbuffers(PluginInfo *goomInfo, int nb);
+
+/* bytes of the frame sized buffers of goom, the screen buffers included */
+size_t goom_memory_footprint(PluginInfo *goomInfo);
+
+/*
+ * same as goom_set_screenbuffer for the next goom_update only, with a buffer of
+ * goom_alloc_screenbuffer that the caller hands over to goom.
+ * goom_update then returns a buffer that belongs to the caller : the given one, or,
+ * when the output of the frame would only be a copy (neutral brightness), the internal
+ * buffer of the frame itself, goom keeping the given buffer in exchange.
+ * either way the caller frees it with goom_free_screenbuffer (or gives it again).
+ * returns 0 if the buffer wasn't accepted (too small for the current resolution).
+ */
+int goom_give_screenbuffer(PluginInfo *goomInfo, void *buffer);
+
+/*
+ * nb frames in a row, the same as nb goom_update : frame i is made of data[i].
+ * frames[i] is a buffer of goom_alloc_screenbuffer given to goom as with
+ * goom_give_screenbuffer, and afterwards the buffer of frame i, belonging to the caller.
+ * songTitle and message go with the first frame only, forceMode with each of them.
+ * the buffer of goom_set_screenbuffer, if any, is kept.
+ * returns the number of frames made : less than nb if frames[i] wasn't accepted.
+ */
+int goom_update_batch (PluginInfo *goomInfo,
+                       const gint16 data[][NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN],
+                       guint32 *frames[], int nb,
+                       int forceMode, float fps, const char *songTitle, const char *message);
+
+/*
+ * the stages of goom_update, timed when libgoom is built with GOOM_PROFILE
+ * (the zoom includes the output of its bands when they are fused).
+ */
+typedef enum {
+    GOOM_STAGE_SOUND,
+    GOOM_STAGE_IFS,
+    GOOM_STAGE_POINTS,
+    GOOM_STAGE_STATE,     /* choice of the state and of the zoom */
+    GOOM_STAGE_ZOOM,
+    GOOM_STAGE_TENTACLES,
+    GOOM_STAGE_STARS,
+    GOOM_STAGE_TEXT,
+    GOOM_STAGE_LINES,
+    GOOM_STAGE_OUTPUT,    /* convolve */
+    GOOM_STAGE_FRAME,     /* all of goom_update */
+    GOOM_NB_STAGES,
+    /* not a stage of goom_update : a new zoom map, made by a background thread */
+    GOOM_STAGE_ZOOM_MAP = GOOM_NB_STAGES
+} GoomStage;
+
+/* microseconds */
+typedef struct {
+    float last, mean, min, max;
+} GoomStageStats;
+
+/*
+ * the times of the stages over the last frames (GOOM_PROFILE_FRAMES at most),
+ * can be called from any thread during a goom_update.
+ * returns the number of frames, 0 without GOOM_PROFILE.
+ */
+int goom_get_stage_stats (PluginInfo *goomInfo, GoomStageStats stats[GOOM_NB_STAGES]);
+const char *goom_stage_name (int stage);
+
+/*
+ * called at the end of each stage, with its time in nanoseconds : on the thread of
+ * goom_update, and for GOOM_STAGE_ZOOM_MAP on the background one. it must be quick.
+ * only with GOOM_PROFILE. set before goom_update runs, NULL for none.
+ */
+typedef void (*GoomStageListener) (void *arg, int stage, unsigned int ns);
+void goom_set_stage_listener (PluginInfo *goomInfo, GoomStageListener listener, void *arg);
+
 void goom_close (PluginInfo *goomInfo);
 
 #endif
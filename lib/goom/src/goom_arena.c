@@ -0,0 +1,346 @@
+/*
+ *  goom_arena.c
+ *  Goom
+ *
+ *  Memory of the frame sized buffers : chunks on huge pages,
+ *  and pools of buffers of the same size taken from them.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "goom_arena.h"
+
+#ifndef _WIN32PC
+#include <pthread.h>
+#endif
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/* memory taken from the system at once, the buffers are cut in it */
+typedef struct _GOOM_CHUNK {
+    struct _GOOM_CHUNK *next;
+    char  *base;
+    size_t size;
+    size_t used;
+} GoomChunk;
+
+/* in the GOOM_ARENA_ALIGN bytes in front of each buffer of a pool */
+typedef struct {
+    GoomPool *pool;
+    int index;
+    int nextFree; /* index of the next free buffer, -1 for none */
+} PoolSlot;
+
+#define POOL_SLOT(buffer) ((PoolSlot *) ((char *) (buffer) - GOOM_ARENA_ALIGN))
+
+struct _GOOM_POOL {
+    struct _GOOM_POOL *next; /* in the list of the arena */
+    GoomArena *arena;
+    size_t size;   /* of the buffers */
+    size_t stride; /* slot + buffer */
+    void **buffers; /* by index */
+    int count, capacity;
+    int firstFree; /* -1 : none */
+    int nbFree;
+};
+
+struct _GOOM_ARENA {
+    GoomChunk *chunks; /* the last one made first */
+    GoomPool *pools;
+    size_t footprint;
+#ifndef _WIN32PC
+    pthread_mutex_t lock;
+#endif
+};
+
+static void arena_lock (GoomArena *arena)
+{
+#ifndef _WIN32PC
+    pthread_mutex_lock (&arena->lock);
+#endif
+}
+
+static void arena_unlock (GoomArena *arena)
+{
+#ifndef _WIN32PC
+    pthread_mutex_unlock (&arena->lock);
+#endif
+}
+
+static size_t align_up (size_t n, size_t align)
+{
+    return (n + align - 1) & ~(align - 1);
+}
+
+/* zeroed memory, *size rounded to what was taken */
+static char *map_memory (size_t *size)
+{
+#ifdef __linux__
+    size_t len = align_up (*size, HUGE_PAGE_SIZE);
+    char *mem;
+    uintptr_t aligned;
+
+#ifdef MAP_HUGETLB
+    /* huge pages reserved by the system, if any */
+    mem = (char *) mmap (NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mem != (char *) MAP_FAILED) {
+        *size = len;
+        return mem;
+    }
+#endif
+    /* else transparent huge pages, which need an aligned range */
+    mem = (char *) mmap (NULL, len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == (char *) MAP_FAILED)
+        return NULL;
+    aligned = align_up ((uintptr_t) mem, HUGE_PAGE_SIZE);
+    if (aligned > (uintptr_t) mem)
+        munmap (mem, aligned - (uintptr_t) mem);
+    munmap ((char *) aligned + len, (uintptr_t) mem + HUGE_PAGE_SIZE - aligned);
+#ifdef MADV_HUGEPAGE
+    madvise ((char *) aligned, len, MADV_HUGEPAGE);
+#endif
+    *size = len;
+    return (char *) aligned;
+#elif defined(_WIN32PC)
+    char *mem = (char *) _aligned_malloc (*size, GOOM_ARENA_ALIGN);
+    if (mem != NULL)
+        memset (mem, 0, *size);
+    return mem;
+#else
+    void *mem = NULL;
+    if (posix_memalign (&mem, GOOM_ARENA_ALIGN, *size) != 0)
+        return NULL;
+    memset (mem, 0, *size);
+    return (char *) mem;
+#endif
+}
+
+static void unmap_memory (char *mem, size_t size)
+{
+#ifdef __linux__
+    munmap (mem, size);
+#elif defined(_WIN32PC)
+    (void) size;
+    _aligned_free (mem);
+#else
+    (void) size;
+    free (mem);
+#endif
+}
+
+/* arena->lock is held */
+static void *arena_alloc (GoomArena *arena, size_t size)
+{
+    GoomChunk *chunk = arena->chunks;
+    void *buffer;
+
+    size = align_up (size, GOOM_ARENA_ALIGN);
+    if ((chunk == NULL) || (chunk->size - chunk->used < size)) {
+        size_t chunkSize = (size > HUGE_PAGE_SIZE) ? size : HUGE_PAGE_SIZE;
+        char *base = map_memory (&chunkSize);
+        if (base == NULL)
+            return NULL;
+        chunk = (GoomChunk *) malloc (sizeof (GoomChunk));
+        chunk->base = base;
+        chunk->size = chunkSize;
+        chunk->used = 0;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        arena->footprint += chunkSize;
+    }
+    buffer = chunk->base + chunk->used;
+    chunk->used += size;
+    return buffer;
+}
+
+GoomArena *goom_arena_new (void)
+{
+    GoomArena *arena = (GoomArena *) malloc (sizeof (GoomArena));
+
+    arena->chunks = NULL;
+    arena->pools = NULL;
+    arena->footprint = 0;
+#ifndef _WIN32PC
+    pthread_mutex_init (&arena->lock, NULL);
+#endif
+    return arena;
+}
+
+void goom_arena_free (GoomArena *arena)
+{
+    if (arena == NULL)
+        return;
+
+    while (arena->pools) {
+        GoomPool *pool = arena->pools;
+        arena->pools = pool->next;
+        free (pool->buffers);
+        free (pool);
+    }
+    while (arena->chunks) {
+        GoomChunk *chunk = arena->chunks;
+        arena->chunks = chunk->next;
+        unmap_memory (chunk->base, chunk->size);
+        free (chunk);
+    }
+#ifndef _WIN32PC
+    pthread_mutex_destroy (&arena->lock);
+#endif
+    free (arena);
+}
+
+size_t goom_arena_footprint (GoomArena *arena)
+{
+    size_t footprint;
+
+    arena_lock (arena);
+    footprint = arena->footprint;
+    arena_unlock (arena);
+    return footprint;
+}
+
+void *goom_arena_alloc (GoomArena *arena, size_t size)
+{
+    void *buffer;
+
+    arena_lock (arena);
+    buffer = arena_alloc (arena, size);
+    arena_unlock (arena);
+    return buffer;
+}
+
+GoomPool *goom_pool_new (GoomArena *arena, size_t size)
+{
+    GoomPool *pool = (GoomPool *) malloc (sizeof (GoomPool));
+
+    pool->arena = arena;
+    pool->size = size;
+    pool->stride = GOOM_ARENA_ALIGN + align_up (size, GOOM_ARENA_ALIGN);
+    pool->buffers = NULL;
+    pool->count = pool->capacity = 0;
+    pool->firstFree = -1;
+    pool->nbFree = 0;
+
+    arena_lock (arena);
+    pool->next = arena->pools;
+    arena->pools = pool;
+    arena_unlock (arena);
+    return pool;
+}
+
+size_t goom_pool_buffer_size (const GoomPool *pool)
+{
+    return pool->size;
+}
+
+/* nb more free buffers, side by side. arena->lock is held */
+static int pool_make (GoomPool *pool, int nb)
+{
+    char *mem;
+    int i;
+
+    if (pool->count + nb > pool->capacity) {
+        int capacity = (pool->capacity > 0) ? pool->capacity : 4;
+        void **buffers;
+        while (capacity < pool->count + nb)
+            capacity *= 2;
+        buffers = (void **) realloc (pool->buffers, capacity * sizeof (void *));
+        if (buffers == NULL)
+            return 0;
+        pool->buffers = buffers;
+        pool->capacity = capacity;
+    }
+
+    mem = (char *) arena_alloc (pool->arena, nb * pool->stride);
+    if (mem == NULL)
+        return 0;
+
+    /* the first one made is taken first */
+    for (i = nb - 1; i >= 0; --i) {
+        char *buffer = mem + i * pool->stride + GOOM_ARENA_ALIGN;
+        PoolSlot *slot = POOL_SLOT (buffer);
+        slot->pool = pool;
+        slot->index = pool->count + i;
+        slot->nextFree = pool->firstFree;
+        pool->firstFree = slot->index;
+        pool->buffers[slot->index] = buffer;
+    }
+    pool->count += nb;
+    pool->nbFree += nb;
+    return 1;
+}
+
+void goom_pool_reserve (GoomPool *pool, int nb)
+{
+    arena_lock (pool->arena);
+    if (nb > pool->nbFree)
+        pool_make (pool, nb - pool->nbFree);
+    arena_unlock (pool->arena);
+}
+
+void *goom_pool_take (GoomPool *pool)
+{
+    void *buffer = NULL;
+
+    arena_lock (pool->arena);
+    if ((pool->firstFree >= 0) || pool_make (pool, 1)) {
+        buffer = pool->buffers[pool->firstFree];
+        pool->firstFree = POOL_SLOT (buffer)->nextFree;
+        pool->nbFree--;
+    }
+    arena_unlock (pool->arena);
+    return buffer;
+}
+
+void goom_pool_give (void *buffer)
+{
+    PoolSlot *slot;
+    GoomPool *pool;
+
+    if (buffer == NULL)
+        return;
+    slot = POOL_SLOT (buffer);
+    pool = slot->pool;
+
+    arena_lock (pool->arena);
+    slot->nextFree = pool->firstFree;
+    pool->firstFree = slot->index;
+    pool->nbFree++;
+    arena_unlock (pool->arena);
+}
+
+int goom_pool_count (GoomPool *pool)
+{
+    int count;
+
+    arena_lock (pool->arena);
+    count = pool->count;
+    arena_unlock (pool->arena);
+    return count;
+}
+
+int goom_pool_index (const void *buffer)
+{
+    return POOL_SLOT (buffer)->index;
+}
+
+GoomPool *goom_pool_of (const void *buffer)
+{
+    return POOL_SLOT (buffer)->pool;
+}
+
+void *goom_pool_buffer (GoomPool *pool, int index)
+{
+    void *buffer = NULL;
+
+    arena_lock (pool->arena);
+    if ((index >= 0) && (index < pool->count))
+        buffer = pool->buffers[index];
+    arena_unlock (pool->arena);
+    return buffer;
+}
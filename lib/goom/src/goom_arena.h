@@ -0,0 +1,54 @@
+#ifndef _GOOM_ARENA_H
+#define _GOOM_ARENA_H
+
+#include <stddef.h>
+
+/**
+ * Memory of the frame sized buffers (screens, zoom maps...).
+ *
+ * The arena takes memory from the system by big chunks, on 2 MB huge pages
+ * when the system has them (less TLB misses on the big frames), and only
+ * gives it back in goom_arena_free. Every buffer is GOOM_ARENA_ALIGN aligned.
+ *
+ * The buffers are handed out by pools of buffers of the same size. A buffer
+ * given back is taken again as is, so once a pool has made enough of them
+ * (goom_pool_reserve), nothing is allocated anymore.
+ *
+ * All the functions are thread safe.
+ */
+
+#define GOOM_ARENA_ALIGN 64
+
+typedef struct _GOOM_ARENA GoomArena;
+typedef struct _GOOM_POOL GoomPool;
+
+GoomArena *goom_arena_new (void);
+/* all the pools and their buffers go with it */
+void goom_arena_free (GoomArena *arena);
+
+/* bytes taken from the system */
+size_t goom_arena_footprint (GoomArena *arena);
+
+/* a buffer that lives as long as the arena, NULL if out of memory */
+void *goom_arena_alloc (GoomArena *arena, size_t size);
+
+/* buffers of size bytes */
+GoomPool *goom_pool_new (GoomArena *arena, size_t size);
+size_t goom_pool_buffer_size (const GoomPool *pool);
+
+/* makes the buffers missing for nb free ones, side by side */
+void goom_pool_reserve (GoomPool *pool, int nb);
+
+/* a free buffer, made if there is none. its content is what it was given back with
+ * (zeros for a new one). NULL if out of memory. */
+void *goom_pool_take (GoomPool *pool);
+/* any buffer of any pool, NULL does nothing */
+void goom_pool_give (void *buffer);
+
+/* the buffers are numbered in the order they were made */
+int goom_pool_count (GoomPool *pool);
+int goom_pool_index (const void *buffer);
+GoomPool *goom_pool_of (const void *buffer);
+void *goom_pool_buffer (GoomPool *pool, int index);
+
+#endif
@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <inttypes.h>
 
 #include "goom.h"
@@ -28,6 +29,10 @@
 
 /* #define VERBOSE */
 
+#if GOOM_MAX_SIZE > ZOOM_MAX_SIZE
+#error "the zoom cannot go as far as GOOM_MAX_SIZE"
+#endif
+
 #define STOP_SPEED 128
 /* TODO: put that as variable in PluginInfo */
 #define TIME_BTW_CHG 300
@@ -36,26 +41,124 @@ static void choose_a_goom_line (PluginInfo *goomInfo, float *param1, float *para
                                 int *mode, float *amplitude, int far);
 
 static void update_message (PluginInfo *goomInfo, const char *message);
+static void draw_output_text (PluginInfo *goomInfo, int x, int y, const char *str, float charspace, int center);
+static void fused_output_band (PluginInfo *goomInfo, int yStart, int yEnd);
 
-static void init_buffers(PluginInfo *goomInfo, int buffsize)
+/* the pool of the screen buffers, a new one when the resolution is bigger than ever */
+static GoomPool *screen_pool (PluginInfo *goomInfo)
 {
-    goomInfo->pixel = (guint32 *) malloc (buffsize * sizeof (guint32) + 128);
-    bzero (goomInfo->pixel, buffsize * sizeof (guint32) + 128);
-    goomInfo->back = (guint32 *) malloc (buffsize * sizeof (guint32) + 128);
-    bzero (goomInfo->back, buffsize * sizeof (guint32) + 128);
-    goomInfo->conv = (Pixel *) malloc (buffsize * sizeof (guint32) + 128);
-    bzero (goomInfo->conv, buffsize * sizeof (guint32) + 128);
+    size_t size = goomInfo->screen.size * sizeof (Pixel);
+    
+    if ((goomInfo->screenPool == NULL) || (goom_pool_buffer_size (goomInfo->screenPool) < size))
+        goomInfo->screenPool = goom_pool_new (goomInfo->arena, size);
+    return goomInfo->screenPool;
+}
 
-    goomInfo->outputBuf = goomInfo->conv;
+void *goom_alloc_screenbuffer (PluginInfo *goomInfo)
+{
+    void *buffer = goom_pool_take (screen_pool (goomInfo));
+    
+    if (buffer != NULL)
+        memset (buffer, 0, goomInfo->screen.size * sizeof (Pixel));
+    return buffer;
+}
+
+void goom_free_screenbuffer (void *buffer)
+{
+    goom_pool_give (buffer);
+}
+
+void goom_reserve_screenbuffers (PluginInfo *goomInfo, int nb)
+{
+    goom_pool_reserve (screen_pool (goomInfo), nb);
+}
+
+size_t goom_memory_footprint (PluginInfo *goomInfo)
+{
+    return goom_arena_footprint (goomInfo->arena);
+}
+
+static int screenbuffer_fits (const PluginInfo *goomInfo, const void *buffer)
+{
+    return (buffer != NULL)
+        && (goom_pool_buffer_size (goom_pool_of (buffer)) >= goomInfo->screen.size * sizeof (Pixel));
+}
+
+/* nearest pixel, the image goes on at the new resolution */
+static void scale_pixels (const Pixel *src, int srcW, int srcH, Pixel *dest, int destW, int destH)
+{
+    int x, y;
+    for (y = 0; y < destH; ++y) {
+        const Pixel *row = src + (y * srcH / destH) * srcW;
+        for (x = 0; x < destW; ++x)
+            *dest++ = row[x * srcW / destW];
+    }
+}
+
+/* *buffer scaled into *spare (allocated if too small), the old *buffer becomes the spare */
+static void rescale_screenbuffer (PluginInfo *goomInfo, Pixel **buffer, Pixel **spare, int oldW, int oldH)
+{
+    Pixel *dest = *spare;
     
-    goomInfo->p1 = (Pixel *) ((1 + ((uintptr_t) (goomInfo->pixel)) / 128) * 128);
-    goomInfo->p2 = (Pixel *) ((1 + ((uintptr_t) (goomInfo->back)) / 128) * 128);
+    if (!screenbuffer_fits (goomInfo, dest)) {
+        goom_free_screenbuffer (dest);
+        dest = (Pixel *) goom_alloc_screenbuffer (goomInfo);
+    }
+    scale_pixels (*buffer, oldW, oldH, dest, goomInfo->screen.width, goomInfo->screen.height);
+    *spare = *buffer;
+    *buffer = dest;
+}
+
+static void update_ifs_incr (int *ifs_incr, int *decay_ifs, int *recay_ifs)
+{
+    (*decay_ifs)--;
+    if (*decay_ifs > 0)
+        *ifs_incr += 2;
+    if (*decay_ifs == 0)
+        *ifs_incr = 0;
+    
+    if (*recay_ifs) {
+        *ifs_incr -= 2;
+        (*recay_ifs)--;
+        if ((*recay_ifs == 0)&&(*ifs_incr<=0))
+            *ifs_incr = 1;
+    }
+}
+
+/* the ifs of the next frame reads p2 before the zoom */
+static int next_frame_reads_p2 (const PluginInfo *goomInfo)
+{
+    int ifs_incr = goomInfo->update.ifs_incr;
+    int decay_ifs = goomInfo->update.decay_ifs;
+    int recay_ifs = goomInfo->update.recay_ifs;
+    
+    update_ifs_incr (&ifs_incr, &decay_ifs, &recay_ifs);
+    return ifs_incr > 0;
+}
+
+static void init_buffers(PluginInfo *goomInfo)
+{
+    goom_reserve_screenbuffers (goomInfo, 3);
+    goomInfo->p1 = (Pixel *) goom_alloc_screenbuffer (goomInfo);
+    goomInfo->p2 = (Pixel *) goom_alloc_screenbuffer (goomInfo);
+    goomInfo->conv = (Pixel *) goom_alloc_screenbuffer (goomInfo);
+
+    goomInfo->outputBuf = goomInfo->conv;
+    goomInfo->outputGiven = 0;
+}
+
+static void free_buffers(PluginInfo *goomInfo)
+{
+    goom_free_screenbuffer (goomInfo->p1);
+    goom_free_screenbuffer (goomInfo->p2);
+    goom_free_screenbuffer (goomInfo->conv);
+    goomInfo->p1 = goomInfo->p2 = goomInfo->conv = NULL;
 }
 
 /**************************
 *         INIT           *
 **************************/
-PluginInfo *goom_init (guint32 resx, guint32 resy)
+static PluginInfo *init_goom (guint32 resx, guint32 resy, guint32 seed, int deterministic)
 {
     PluginInfo *goomInfo = (PluginInfo*)malloc(sizeof(PluginInfo));
     
@@ -65,6 +168,25 @@ PluginInfo *goom_init (guint32 resx, guint32 resy)
     
     plugin_info_init(goomInfo,4);
     
+    /* before the FXs, which make random choices in their init */
+    goomInfo->gRandom = goom_random_init(seed);
+    goomInfo->deterministic = deterministic;
+    
+    goomInfo->arena = goom_arena_new();
+    goomInfo->screenPool = NULL;
+    
+    goomInfo->threads = goom_thread_pool_new(0);
+#ifdef GOOM_PROFILE
+    goomInfo->profile = goom_profile_new();
+#else
+    goomInfo->profile = NULL;
+#endif
+    
+    /* the FXs make their buffers for it */
+    goomInfo->screen.width = resx;
+    goomInfo->screen.height = resy;
+    goomInfo->screen.size = resx * resy;
+    
     goomInfo->star_fx = flying_star_create();
     goomInfo->star_fx.init(&goomInfo->star_fx, goomInfo);
     
@@ -82,14 +204,10 @@ PluginInfo *goom_init (guint32 resx, guint32 resy)
     plugin_info_add_visual (goomInfo, 2, &goomInfo->star_fx);
     plugin_info_add_visual (goomInfo, 3, &goomInfo->convolve_fx);
     
-    goomInfo->screen.width = resx;
-    goomInfo->screen.height = resy;
-    goomInfo->screen.size = resx * resy;
-    
-    init_buffers(goomInfo, goomInfo->screen.size);
-    goomInfo->gRandom = goom_random_init((uintptr_t)goomInfo->pixel);
+    init_buffers(goomInfo);
     
     goomInfo->cycle = 0;
+    goomInfo->outputFade = 1.0f;
     
     goomInfo->ifs_fx = ifs_visualfx_create();
     goomInfo->ifs_fx.init(&goomInfo->ifs_fx, goomInfo);
@@ -108,19 +226,52 @@ PluginInfo *goom_init (guint32 resx, guint32 resy)
     return goomInfo;
 }
 
+static int size_allowed (guint32 resx, guint32 resy)
+{
+    return (resx > 0) && (resy > 0) && (resx <= GOOM_MAX_SIZE) && (resy <= GOOM_MAX_SIZE);
+}
+
+PluginInfo *goom_init (guint32 resx, guint32 resy)
+{
+    if (!size_allowed (resx, resy))
+        return NULL;
+    /* different at each run */
+    return init_goom (resx, resy, (guint32)(uintptr_t)&resx ^ (guint32)time (NULL), 0);
+}
+
+PluginInfo *goom_init_seeded (guint32 resx, guint32 resy, guint32 seed)
+{
+    if (!size_allowed (resx, resy))
+        return NULL;
+    return init_goom (resx, resy, seed, 1);
+}
 
 
-void goom_set_resolution (PluginInfo *goomInfo, guint32 resx, guint32 resy)
+
+int goom_set_resolution (PluginInfo *goomInfo, guint32 resx, guint32 resy)
 {
-    free (goomInfo->pixel);
-    free (goomInfo->back);
-    free (goomInfo->conv);
+    const int oldW = goomInfo->screen.width;
+    const int oldH = goomInfo->screen.height;
+    Pixel *spare = goomInfo->conv;
+    
+    if (!size_allowed (resx, resy))
+        return 0;
+    if ((resx == (guint32)oldW) && (resy == (guint32)oldH))
+        return 1;
     
     goomInfo->screen.width = resx;
     goomInfo->screen.height = resy;
     goomInfo->screen.size = resx * resy;
     
-    init_buffers(goomInfo, goomInfo->screen.size);
+    /* no allocation as long as the buffers are big enough, conv is the spare one */
+    rescale_screenbuffer (goomInfo, &goomInfo->p1, &spare, oldW, oldH);
+    rescale_screenbuffer (goomInfo, &goomInfo->p2, &spare, oldW, oldH);
+    if (!screenbuffer_fits (goomInfo, spare)) {
+        goom_free_screenbuffer (spare);
+        spare = (Pixel *) goom_alloc_screenbuffer (goomInfo);
+    }
+    goomInfo->conv = goomInfo->outputBuf = spare;
+    goomInfo->outputGiven = 0;
     
     /* init_ifs (goomInfo, resx, goomInfo->screen.height); */
     goomInfo->ifs_fx.free(&goomInfo->ifs_fx);
@@ -128,11 +279,33 @@ void goom_set_resolution (PluginInfo *goomInfo, guint32 resx, guint32 resy)
     
     goom_lines_set_res (goomInfo->gmline1, resx, goomInfo->screen.height);
     goom_lines_set_res (goomInfo->gmline2, resx, goomInfo->screen.height);
+    return 1;
+}
+
+void goom_set_threads (PluginInfo *goomInfo, int nbThreads)
+{
+    goom_thread_pool_free (goomInfo->threads);
+    goomInfo->threads = goom_thread_pool_new (nbThreads);
 }
 
 int goom_set_screenbuffer(PluginInfo *goomInfo, void *buffer)
 {
   goomInfo->outputBuf = (Pixel*)buffer;
+  goomInfo->outputGiven = 0;
+  return 1;
+}
+
+void goom_set_fade(PluginInfo *goomInfo, float fade)
+{
+  goomInfo->outputFade = fade;
+}
+
+int goom_give_screenbuffer(PluginInfo *goomInfo, void *buffer)
+{
+  if (!screenbuffer_fits(goomInfo, buffer))
+    return 0;
+  goomInfo->outputBuf = (Pixel*)buffer;
+  goomInfo->outputGiven = 1;
   return 1;
 }
 
@@ -152,15 +325,20 @@ guint32 *goom_update (PluginInfo *goomInfo,
     int     i;
     float   largfactor;	/* elargissement de l'intervalle d'évolution des points */
     Pixel *tmp;
+    int     fused;
+    int     exchange = 0;
     
     ZoomFilterData *pzfd;
     
+    GOOM_PROFILE_START (goomInfo);
+    
     /* test if the config has changed, update it if so */
     pointWidth = (goomInfo->screen.width * 2) / 5;
     pointHeight = ((goomInfo->screen.height) * 2) / 5;
     
     /* ! etude du signal ... */
     evaluate_sound (data, &(goomInfo->sound));
+    GOOM_PROFILE_LAP (goomInfo, GOOM_STAGE_SOUND);
     
     /* goom_execute_main_script(goomInfo); */
     
@@ -170,21 +348,11 @@ guint32 *goom_update (PluginInfo *goomInfo,
     if (largfactor > 1.5f)
         largfactor = 1.5f;
     
-    goomInfo->update.decay_ifs--;
-    if (goomInfo->update.decay_ifs > 0)
-        goomInfo->update.ifs_incr += 2;
-    if (goomInfo->update.decay_ifs == 0)
-        goomInfo->update.ifs_incr = 0;
-    
-    if (goomInfo->update.recay_ifs) {
-        goomInfo->update.ifs_incr -= 2;
-        goomInfo->update.recay_ifs--;
-        if ((goomInfo->update.recay_ifs == 0)&&(goomInfo->update.ifs_incr<=0))
-            goomInfo->update.ifs_incr = 1;
-    }
+    update_ifs_incr (&goomInfo->update.ifs_incr, &goomInfo->update.decay_ifs, &goomInfo->update.recay_ifs);
     
     if (goomInfo->update.ifs_incr > 0)
         goomInfo->ifs_fx.apply(&goomInfo->ifs_fx, goomInfo->p2, goomInfo->p1, goomInfo);
+    GOOM_PROFILE_LAP (goomInfo, GOOM_STAGE_IFS);
     
     if (goomInfo->curGState->drawPoints) {
         const int speedvarMult80Plus15 = goomInfo->sound.speedvar*80;
@@ -240,6 +408,7 @@ guint32 *goom_update (PluginInfo *goomInfo,
             pointFilter(goomInfo, goomInfo->p1, WHITE,  white_t1,  white_t2,  white_t3,  white_t4,  white_cycle);
         }
     }
+    GOOM_PROFILE_LAP (goomInfo, GOOM_STAGE_POINTS);
     
     /* par défaut pas de changement de zoom */
     pzfd = NULL;
@@ -390,7 +559,7 @@ guint32 *goom_update (PluginInfo *goomInfo,
                     goomInfo->update.lockvar = 50;
                     newvit = STOP_SPEED + 1 - ((float)3.5f * log10(goomInfo->sound.speedvar * 60 + 1));
                     /* retablir le zoom avant.. */
-                    if ((goomInfo->update.zoomFilterData.reverse) && (!(goomInfo->cycle % 13)) && (rand () % 5 == 0)) {
+                    if ((goomInfo->update.zoomFilterData.reverse) && (!(goomInfo->cycle % 13)) && (goom_irand (goomInfo->gRandom, 5) == 0)) {
                         goomInfo->update.zoomFilterData.reverse = 0;
                         goomInfo->update.zoomFilterData.vitesse = STOP_SPEED - 2;
                         goomInfo->update.lockvar = 75;
@@ -618,17 +787,36 @@ guint32 *goom_update (PluginInfo *goomInfo,
             printf ("GOOM: pzfd->mode = %d\n", pzfd->mode);
         }
 #endif
+        GOOM_PROFILE_LAP (goomInfo, GOOM_STAGE_STATE);
+        
+        /* Fused Output : the displayed buffer is p1, the source of the zoom. its output is made by the
+         * bands of the zoom while their source lines are in the cache, then the few pixels drawn on it
+         * afterwards (tentacles, stars, text) are recorded and only those are made again at the end. */
+        fused = convolve_fused (&goomInfo->convolve_fx);
+        if (fused) {
+            exchange = convolve_prepare (&goomInfo->convolve_fx, goomInfo, goomInfo->cycle + 1)
+                && goomInfo->outputGiven && !next_frame_reads_p2 (goomInfo);
+            if (!exchange) {
+                goomInfo->zoomBandHook = fused_output_band;
+                goomInfo->overlay.nb = 0;
+                goomInfo->overlay.record = 1;
+            }
+        }
+        GOOM_PROFILE_LAP (goomInfo, GOOM_STAGE_OUTPUT);
         
         /* Zoom here ! */
         zoomFilterFastRGB (goomInfo, goomInfo->p1, goomInfo->p2, pzfd, goomInfo->screen.width, goomInfo->screen.height,
                            goomInfo->update.switchIncr, goomInfo->update.switchMult);
+        GOOM_PROFILE_LAP (goomInfo, GOOM_STAGE_ZOOM);
         
         /*
          * Affichage tentacule
          */
         
         goomInfo->tentacles_fx.apply(&goomInfo->tentacles_fx, goomInfo->p1, goomInfo->p2, goomInfo);
+        GOOM_PROFILE_LAP (goomInfo, GOOM_STAGE_TENTACLES);
         goomInfo->star_fx.apply (&goomInfo->star_fx,goomInfo->p2,goomInfo->p1,goomInfo);
+        GOOM_PROFILE_LAP (goomInfo, GOOM_STAGE_STARS);
         
         /*
          * Affichage de texte
@@ -644,8 +832,7 @@ guint32 *goom_update (PluginInfo *goomInfo,
             
             if (fps > 0) {
                 sprintf (text, "%2.0f fps", fps);
-                goom_draw_text (goomInfo->p1,goomInfo->screen.width,goomInfo->screen.height,
-                                10, 24, text, 1, 0);
+                draw_output_text (goomInfo, 10, 24, text, 1, 0);
             }
             
             /*
@@ -658,9 +845,8 @@ guint32 *goom_update (PluginInfo *goomInfo,
             }
             
             if (goomInfo->update.timeOfTitleDisplay) {
-                goom_draw_text (goomInfo->p1,goomInfo->screen.width,goomInfo->screen.height,
-                                goomInfo->screen.width / 2, goomInfo->screen.height / 2 + 7, goomInfo->update.titleText,
-                                ((float) (190 - goomInfo->update.timeOfTitleDisplay) / 10.0f), 1);
+                draw_output_text (goomInfo, goomInfo->screen.width / 2, goomInfo->screen.height / 2 + 7, goomInfo->update.titleText,
+                                  ((float) (190 - goomInfo->update.timeOfTitleDisplay) / 10.0f), 1);
                 goomInfo->update.timeOfTitleDisplay--;
                 if (goomInfo->update.timeOfTitleDisplay < 4)
                     goom_draw_text (goomInfo->p2,goomInfo->screen.width,goomInfo->screen.height,
@@ -668,6 +854,7 @@ guint32 *goom_update (PluginInfo *goomInfo,
                                     ((float) (190 - goomInfo->update.timeOfTitleDisplay) / 10.0f), 1);
             }
         }
+        GOOM_PROFILE_LAP (goomInfo, GOOM_STAGE_TEXT);
         
         /*
          * Gestion du Scope
@@ -756,6 +943,8 @@ guint32 *goom_update (PluginInfo *goomInfo,
             }
         }
         
+        GOOM_PROFILE_LAP (goomInfo, GOOM_STAGE_LINES);
+        
         return_val = goomInfo->p1;
         tmp = goomInfo->p1;
         goomInfo->p1 = goomInfo->p2;
@@ -764,25 +953,87 @@ guint32 *goom_update (PluginInfo *goomInfo,
         /* affichage et swappage des buffers.. */
         goomInfo->cycle++;
         
-        goomInfo->convolve_fx.apply(&goomInfo->convolve_fx,return_val,goomInfo->outputBuf,goomInfo);
+        if (!fused)
+            exchange = convolve_prepare (&goomInfo->convolve_fx, goomInfo, goomInfo->cycle)
+                && goomInfo->outputGiven && !next_frame_reads_p2 (goomInfo);
+        
+        if (exchange) {
+            /* the output would be a copy of the displayed buffer : it goes to the caller as it is,
+             * and the given buffer takes its place (the next zoom overwrites it). */
+            goomInfo->p2 = goomInfo->outputBuf;
+            goomInfo->outputBuf = return_val;
+        }
+        else if (!fused)
+            convolve_output_screen (&goomInfo->convolve_fx, return_val, goomInfo->outputBuf, goomInfo);
+        else {
+            goomInfo->overlay.record = 0;
+            if (goomInfo->zoomBandHook != NULL) {
+                /* the zoom is disabled, nothing has been done yet */
+                goomInfo->zoomBandHook = NULL;
+                convolve_output (&goomInfo->convolve_fx, return_val, goomInfo->outputBuf, goomInfo,
+                                 0, 0, goomInfo->screen.width, goomInfo->screen.height);
+            }
+            else {
+                for (i = 0; i < goomInfo->overlay.nb; i++) {
+                    const GoomRect *r = &goomInfo->overlay.rects[i];
+                    convolve_output (&goomInfo->convolve_fx, return_val, goomInfo->outputBuf, goomInfo,
+                                     r->x0, r->y0, r->x1, r->y1);
+                }
+            }
+        }
+        
+        GOOM_PROFILE_LAP (goomInfo, GOOM_STAGE_OUTPUT);
+        GOOM_PROFILE_END (goomInfo);
         
+        if (goomInfo->outputGiven) {
+            /* the caller owns it now */
+            return_val = goomInfo->outputBuf;
+            goomInfo->outputBuf = goomInfo->conv;
+            goomInfo->outputGiven = 0;
+            return (guint32*)return_val;
+        }
         return (guint32*)goomInfo->outputBuf;
 }
 
+int goom_update_batch (PluginInfo *goomInfo,
+                       const gint16 data[][NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN],
+                       guint32 *frames[], int nb,
+                       int forceMode, float fps, const char *songTitle, const char *message)
+{
+    Pixel *outputBuf = goomInfo->outputGiven ? goomInfo->conv : goomInfo->outputBuf;
+    int i;
+
+    for (i = 0; i < nb; ++i) {
+        if (!goom_give_screenbuffer (goomInfo, frames[i]))
+            break;
+        frames[i] = goom_update (goomInfo, data[i], forceMode, fps,
+                                 (i == 0) ? songTitle : NULL, (i == 0) ? message : NULL);
+    }
+    goomInfo->outputBuf = outputBuf;
+    goomInfo->outputGiven = 0;
+    return i;
+}
+
+/* the output of the lines [yStart..yEnd[ of the displayed buffer, called by the bands of the zoom */
+static void fused_output_band (PluginInfo *goomInfo, int yStart, int yEnd)
+{
+    convolve_output (&goomInfo->convolve_fx, goomInfo->p1, goomInfo->outputBuf, goomInfo,
+                     0, yStart, goomInfo->screen.width, yEnd);
+}
+
+/* goom_draw_text on the displayed buffer */
+static void draw_output_text (PluginInfo *goomInfo, int x, int y, const char *str, float charspace, int center)
+{
+    goom_draw_text (goomInfo->p1, goomInfo->screen.width, goomInfo->screen.height, x, y, str, charspace, center);
+    plugin_info_overlay_rect (goomInfo, 0, y - goom_text_height (), goomInfo->screen.width, y);
+}
+
 /****************************************
 *                CLOSE                 *
 ****************************************/
 void goom_close (PluginInfo *goomInfo)
 {
-    if (goomInfo->pixel != NULL)
-        free (goomInfo->pixel);
-    if (goomInfo->back != NULL)
-        free (goomInfo->back);
-    if (goomInfo->conv != NULL)
-        free (goomInfo->conv);
-    
-    goomInfo->pixel = goomInfo->back = NULL;
-    goomInfo->conv = NULL;
+    free_buffers(goomInfo);
     goom_random_free(goomInfo->gRandom);
     goom_lines_free (&goomInfo->gmline1);
     goom_lines_free (&goomInfo->gmline2);
@@ -793,6 +1044,12 @@ void goom_close (PluginInfo *goomInfo)
     goomInfo->star_fx.free(&goomInfo->star_fx);
     goomInfo->tentacles_fx.free(&goomInfo->tentacles_fx);
     goomInfo->zoomFilter_fx.free(&goomInfo->zoomFilter_fx);
+    
+    goom_thread_pool_free(goomInfo->threads);
+    goom_arena_free(goomInfo->arena);
+#ifdef GOOM_PROFILE
+    goom_profile_free(goomInfo->profile);
+#endif
 
     // Release info visual
     free (goomInfo->params);
@@ -802,6 +1059,7 @@ void goom_close (PluginInfo *goomInfo)
     free (goomInfo->visuals);
     gsl_free (goomInfo->scanner);
     gsl_free (goomInfo->main_scanner);
+    free (goomInfo->overlay.rects);
     
     free(goomInfo);
 }
@@ -908,11 +1166,11 @@ static void update_message (PluginInfo *goomInfo, const char *message) {
                 pos = (int)goomInfo->screen.height / 2;
             pos += 7;
             
-            goom_draw_text(goomInfo->p1,goomInfo->screen.width,goomInfo->screen.height,
-                           goomInfo->screen.width/2, pos,
-                           message,
-                           ecart,
-                           1);
+            draw_output_text(goomInfo,
+                             goomInfo->screen.width/2, pos,
+                             message,
+                             ecart,
+                             1);
             message = ++ptr;
             i++;
         }
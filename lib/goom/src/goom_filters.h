@@ -27,6 +27,27 @@ struct _ZOOM_FILTER_DATA
 	char    noisify;           /* ajoute un bruit a la transformation */
 };
 
+/* buffer de transformation du zoom : position dans la source de chaque pixel
+ * de la destination, en 1/16 de pixel. Un plan pour les X, un pour les Y.
+ * The positions are saturated to fit on 16 bits, so the screen must not be
+ * bigger than ZOOM_MAX_SIZE in both directions. */
+struct _ZOOM_TRANSFORM
+{
+	gint16 *x;
+	gint16 *y;
+};
+
+#define ZOOM_MAX_SIZE 2047
+
+/* regime etabli : when the ratio between the two transforms does not move,
+ * they are collapsed in one word per pixel : (pos << ZOOM_STEADY_COEF_BITS) | coef.
+ * pos : first of the 4 source pixels, coef : index in the table of the 4 coefs
+ * (px&0xf)*16+(py&0xf), or ZOOM_STEADY_NO_COEF (null coefs) out of the screen. */
+#define ZOOM_STEADY_COEF_BITS 9
+#define ZOOM_STEADY_COEF_MASK 0x1ff
+#define ZOOM_STEADY_NO_COEF 256
+#define ZOOM_STEADY_NB_COEFS 257
+
 #define NORMAL_MODE 0
 #define WAVE_MODE 1
 #define CRYSTAL_BALL_MODE 2
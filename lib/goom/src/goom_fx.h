@@ -4,9 +4,25 @@
 #include "goom_visual_fx.h"
 #include "goom_plugin_info.h"
 
+/* the motif of the convolve FX, a CONV_MOTIF_W x CONV_MOTIF_W texture */
+#define CONV_MOTIF_W 128
+#define CONV_MOTIF_WMASK 0x7f
+
 VisualFX convolve_create ();
+
+/* the output of the displayed buffer in pieces, cf goom_update (Fused Output).
+ * convolve_prepare is called once per frame, then convolve_output on each part of the screen,
+ * or convolve_output_screen on all of it.
+ * convolve_prepare returns 1 when the output of the frame is a plain copy of its source. */
+int  convolve_fused (VisualFX *_this);
+int  convolve_prepare (VisualFX *_this, PluginInfo *info, guint32 cycle);
+void convolve_output (VisualFX *_this, Pixel *src, Pixel *dest, PluginInfo *info, int x0, int y0, int x1, int y1);
+void convolve_output_screen (VisualFX *_this, Pixel *src, Pixel *dest, PluginInfo *info);
 VisualFX flying_star_create (void);
 
-void zoom_filter_c(int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16]);
+void zoom_filter_c(int sizeX, int sizeY, int start, int end, Pixel *src, Pixel *dest, const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16]);
+void create_output_with_brightness_c(Pixel *src, Pixel *dest, int n, int xtex, int ytex, int c, int s, const int *texture);
+void create_output_with_uniform_brightness_c(Pixel *src, Pixel *dest, int n, int iff);
+void zoom_filter_steady_c(int sizeX, int start, int end, Pixel *src, Pixel *dest, const guint32 *steady, const int coefs[ZOOM_STEADY_NB_COEFS]);
 
 #endif
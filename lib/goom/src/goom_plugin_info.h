@@ -11,6 +11,9 @@
 #include "goom_filters.h"
 #include "goom_tools.h"
 #include "goomsl.h"
+#include "thread_pool.h"
+#include "goom_arena.h"
+#include "goom_profile.h"
 
 typedef struct {
 	char drawIFS;
@@ -68,6 +71,11 @@ struct _SOUND_INFO {
 	PluginParameters params; /* contains the previously defined parameters. */
 };
 
+/** the pixels [x0..x1[ x [y0..y1[ of the screen */
+typedef struct {
+	int x0, y0, x1, y1;
+} GoomRect;
+
 
 /**
  * Allows FXs to know the current state of the plugin.
@@ -99,12 +107,16 @@ struct _PLUGIN_INFO {
 	VisualFX tentacles_fx;
 	VisualFX ifs_fx;
 
-	/** image buffers */
-	guint32 *pixel;
-	guint32 *back;
+	/** the frame sized buffers, screenPool is the one of the current resolution */
+	GoomArena *arena;
+	GoomPool *screenPool;
+
+	/** image buffers (goom_alloc_screenbuffer) */
 	Pixel *p1, *p2;
 	Pixel *conv;
   Pixel *outputBuf;
+  int outputGiven; /* outputBuf comes from goom_give_screenbuffer */
+  float outputFade; /* goom_set_fade, multiplies the brightness of the output */
 
 	/** state of goom */
 	guint32 cycle;
@@ -158,10 +170,39 @@ struct _PLUGIN_INFO {
 
 	struct {
 		void (*draw_line) (Pixel *data, int x1, int y1, int x2, int y2, int col, int screenx, int screeny);
-		void (*zoom_filter) (int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16]);
+		/* only the destination pixels [start..end[ are computed */
+		void (*zoom_filter) (int sizeX, int sizeY, int start, int end, Pixel *src, Pixel *dest, const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16]);
+		/* same as zoom_filter, but gives exactly the same result as zoom_filter_c */
+		void (*zoom_filter_exact) (int sizeX, int sizeY, int start, int end, Pixel *src, Pixel *dest, const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16]);
+		/* same result as zoom_filter_exact, from the collapsed transform of the steady state (cf ZOOM_STEADY_COEF_BITS) */
+		void (*zoom_filter_steady) (int sizeX, int start, int end, Pixel *src, Pixel *dest, const guint32 *steady, const int coefs[ZOOM_STEADY_NB_COEFS]);
+		/* n pixels of the output of convolve_fx : each channel of the pixel k, times the multiplier of the texture
+		 * (CONV_MOTIF_W x CONV_MOTIF_W) at (xtex + (k+1)*c, ytex - (k+1)*s) 16:16, >> 8 and saturated. alpha is cleared. */
+		void (*create_output_with_brightness) (Pixel *src, Pixel *dest, int n, int xtex, int ytex, int c, int s, const int *texture);
+		/* same with the multiplier iff for all the pixels */
+		void (*create_output_with_uniform_brightness) (Pixel *src, Pixel *dest, int n, int iff);
 	} methods;
 	
 	GoomRandom *gRandom;
+	int deterministic; /* goom_init_seeded */
+
+	/** workers for the full frame passes */
+	GoomThreadPool *threads;
+
+	/** times of the stages of goom_update, NULL without GOOM_PROFILE */
+	GoomProfile *profile;
+
+	/** called by the next zoomFilterFastRGB on each band of lines [yStart..yEnd[,
+	 * once the band is zoomed. the zoom clears it when it has been used. */
+	void (*zoomBandHook) (PluginInfo *goomInfo, int yStart, int yEnd);
+
+	/** what is drawn on the displayed buffer once its output is done (cf goom_update, Fused Output).
+	 * only filled while record is set, see plugin_info_overlay_line and plugin_info_overlay_rect. */
+	struct {
+		int record;
+		int nb, max;
+		GoomRect *rects;
+	} overlay;
     
     GoomSL *scanner;
     GoomSL *main_scanner;
@@ -170,7 +211,16 @@ struct _PLUGIN_INFO {
 
 void plugin_info_init(PluginInfo *p, int nbVisual); 
 
+/* the methods of a cpu with only these options (CPU_OPTION_*) of the ones it has :
+ * 0 for the C ones. for the tests, not during a goom_update. */
+void plugin_info_set_cpu_flavour(PluginInfo *p, unsigned int cpuFlavour);
+
 /* i = [0..p->nbVisual-1] */
 void plugin_info_add_visual(PluginInfo *p, int i, VisualFX *visual);
 
+/* records the pixels touched by methods.draw_line (x1,y1,x2,y2) on the displayed buffer */
+void plugin_info_overlay_line(PluginInfo *p, int x1, int y1, int x2, int y2);
+/* records the pixels [x0..x1[ x [y0..y1[, clipped to the screen */
+void plugin_info_overlay_rect(PluginInfo *p, int x0, int y0, int x1, int y1);
+
 #endif
@@ -0,0 +1,176 @@
+/*
+ *  goom_profile.c
+ *  Goom
+ *
+ *  Time of the stages of goom_update, in a ring of the last frames.
+ */
+
+#include <string.h>
+
+#include "goom.h"
+#include "goom_profile.h"
+
+static const char *stageNames[GOOM_NB_STAGES + 1] = {
+    "sound", "ifs", "points", "state", "zoom", "tentacles",
+    "stars", "text", "lines", "output", "frame", "zoom map"
+};
+
+const char *goom_stage_name (int stage)
+{
+    if ((stage < 0) || (stage > GOOM_STAGE_ZOOM_MAP))
+        return "?";
+    return stageNames[stage];
+}
+
+#ifdef GOOM_PROFILE
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#ifdef _WIN32PC
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+struct _GOOM_PROFILE {
+    /* frames put in the ring, the last one is at (frames - 1) % GOOM_PROFILE_FRAMES.
+     * goom_update is the only writer */
+    atomic_uint frames;
+    atomic_uint ns[GOOM_PROFILE_FRAMES][GOOM_NB_STAGES];
+
+    /* the frame being timed, goom_update only */
+    unsigned long long start, lap;
+    unsigned int current[GOOM_NB_STAGES];
+
+    GoomStageListener listener;
+    void *listenerArg;
+};
+
+unsigned long long goom_profile_now (void)
+{
+#ifdef _WIN32PC
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter (&count);
+    QueryPerformanceFrequency (&freq);
+    return (unsigned long long) ((double) count.QuadPart * 1e9 / (double) freq.QuadPart);
+#else
+    struct timespec t;
+    clock_gettime (CLOCK_MONOTONIC, &t);
+    return (unsigned long long) t.tv_sec * 1000000000ULL + (unsigned long long) t.tv_nsec;
+#endif
+}
+
+GoomProfile *goom_profile_new (void)
+{
+    GoomProfile *profile = (GoomProfile *) calloc (1, sizeof (GoomProfile));
+    atomic_init (&profile->frames, 0);
+    return profile;
+}
+
+void goom_profile_free (GoomProfile *profile)
+{
+    free (profile);
+}
+
+void goom_profile_start (GoomProfile *profile)
+{
+    memset (profile->current, 0, sizeof (profile->current));
+    profile->start = profile->lap = goom_profile_now ();
+}
+
+void goom_profile_lap (GoomProfile *profile, int stage)
+{
+    unsigned long long t = goom_profile_now ();
+    unsigned int ns = (unsigned int) (t - profile->lap);
+    profile->current[stage] += ns;
+    profile->lap = t;
+    if (profile->listener)
+        profile->listener (profile->listenerArg, stage, ns);
+}
+
+void goom_profile_end (GoomProfile *profile)
+{
+    unsigned int frames = atomic_load_explicit (&profile->frames, memory_order_relaxed);
+    atomic_uint *ns = profile->ns[frames % GOOM_PROFILE_FRAMES];
+    int s;
+
+    profile->current[GOOM_STAGE_FRAME] = (unsigned int) (goom_profile_now () - profile->start);
+    for (s = 0; s < GOOM_NB_STAGES; ++s)
+        atomic_store_explicit (&ns[s], profile->current[s], memory_order_relaxed);
+    atomic_store_explicit (&profile->frames, frames + 1, memory_order_release);
+    if (profile->listener)
+        profile->listener (profile->listenerArg, GOOM_STAGE_FRAME, profile->current[GOOM_STAGE_FRAME]);
+}
+
+void goom_profile_event (GoomProfile *profile, int stage, unsigned long long start)
+{
+    if (profile->listener)
+        profile->listener (profile->listenerArg, stage, (unsigned int) (goom_profile_now () - start));
+}
+
+void goom_set_stage_listener (PluginInfo *goomInfo, GoomStageListener listener, void *arg)
+{
+    goomInfo->profile->listener = listener;
+    goomInfo->profile->listenerArg = arg;
+}
+
+int goom_get_stage_stats (PluginInfo *goomInfo, GoomStageStats stats[GOOM_NB_STAGES])
+{
+    GoomProfile *profile = goomInfo->profile;
+    unsigned int ns[GOOM_PROFILE_FRAMES][GOOM_NB_STAGES];
+    unsigned int frames, nb, written;
+    unsigned int i;
+    int s;
+
+    /* the newest frames first. then the ones goom_update may have overwritten meanwhile are
+     * left out : it has written the written frames after them, and may be writing one more. */
+    frames = atomic_load_explicit (&profile->frames, memory_order_acquire);
+    nb = (frames < GOOM_PROFILE_FRAMES) ? frames : GOOM_PROFILE_FRAMES;
+    for (i = 0; i < nb; ++i)
+        for (s = 0; s < GOOM_NB_STAGES; ++s)
+            ns[i][s] = atomic_load_explicit (&profile->ns[(frames - 1 - i) % GOOM_PROFILE_FRAMES][s],
+                                             memory_order_relaxed);
+    atomic_thread_fence (memory_order_acquire);
+    written = atomic_load_explicit (&profile->frames, memory_order_relaxed) - frames;
+    if (written >= GOOM_PROFILE_FRAMES - 1)
+        nb = 0;
+    else if (nb > GOOM_PROFILE_FRAMES - 1 - written)
+        nb = GOOM_PROFILE_FRAMES - 1 - written;
+
+    for (s = 0; s < GOOM_NB_STAGES; ++s) {
+        double sum = 0.0;
+        stats[s].last = stats[s].mean = stats[s].min = stats[s].max = 0.0f;
+        for (i = 0; i < nb; ++i) {
+            float us = (float) ns[i][s] / 1000.0f;
+            if ((i == 0) || (us < stats[s].min))
+                stats[s].min = us;
+            if (us > stats[s].max)
+                stats[s].max = us;
+            sum += us;
+        }
+        if (nb > 0) {
+            stats[s].last = (float) ns[0][s] / 1000.0f;
+            stats[s].mean = (float) (sum / nb);
+        }
+    }
+    return (int) nb;
+}
+
+#else
+
+int goom_get_stage_stats (PluginInfo *goomInfo, GoomStageStats stats[GOOM_NB_STAGES])
+{
+    (void) goomInfo;
+    memset (stats, 0, GOOM_NB_STAGES * sizeof (GoomStageStats));
+    return 0;
+}
+
+void goom_set_stage_listener (PluginInfo *goomInfo, GoomStageListener listener, void *arg)
+{
+    (void) goomInfo;
+    (void) listener;
+    (void) arg;
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef _GOOM_PROFILE_H
+#define _GOOM_PROFILE_H
+
+/**
+ * Time of the stages of goom_update (cf GoomStage, goom_get_stage_stats).
+ *
+ * Only built with GOOM_PROFILE defined : otherwise the macros are empty and
+ * PluginInfo.profile stays NULL, nothing is left of it in goom_update.
+ *
+ * Each GOOM_PROFILE_LAP gives the time since the previous one (or since
+ * GOOM_PROFILE_START) to a stage. GOOM_PROFILE_END puts the times of the frame
+ * in a ring of the last GOOM_PROFILE_FRAMES frames, which can be read from
+ * another thread without stopping goom_update.
+ */
+
+#define GOOM_PROFILE_FRAMES 128
+
+typedef struct _GOOM_PROFILE GoomProfile;
+
+#ifdef GOOM_PROFILE
+
+GoomProfile *goom_profile_new (void);
+void goom_profile_free (GoomProfile *profile);
+
+void goom_profile_start (GoomProfile *profile);
+void goom_profile_lap (GoomProfile *profile, int stage);
+void goom_profile_end (GoomProfile *profile);
+
+/* a stage out of goom_update (GOOM_STAGE_ZOOM_MAP), only for the listener */
+unsigned long long goom_profile_now (void);
+void goom_profile_event (GoomProfile *profile, int stage, unsigned long long start);
+
+#define GOOM_PROFILE_START(goomInfo) goom_profile_start ((goomInfo)->profile)
+#define GOOM_PROFILE_LAP(goomInfo, stage) goom_profile_lap ((goomInfo)->profile, (stage))
+#define GOOM_PROFILE_END(goomInfo) goom_profile_end ((goomInfo)->profile)
+
+#else
+
+#define GOOM_PROFILE_START(goomInfo)
+#define GOOM_PROFILE_LAP(goomInfo, stage)
+#define GOOM_PROFILE_END(goomInfo)
+
+#endif
+
+#endif
@@ -1,9 +1,22 @@
 #include "goom_tools.h"
 #include <stdlib.h>
 
-GoomRandom *goom_random_init(int i) {
+/* xorshift32 : 31 bits like rand() of glibc, the values of the array stay the same size */
+static int goom_random_next(GoomRandom *grandom) {
+	unsigned int x = grandom->state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	grandom->state = x;
+	return (int)(x >> 1);
+}
+
+GoomRandom *goom_random_init(unsigned int seed) {
 	GoomRandom *grandom = (GoomRandom*)malloc(sizeof(GoomRandom));
-	srand (i);
+	/* any seed, 0 included : xorshift must not start from 0 */
+	grandom->state = (seed * 2654435761u) ^ 0x9e3779b9u;
+	if (grandom->state == 0)
+		grandom->state = 1;
 	grandom->pos = 1;
 	goom_random_update_array(grandom, GOOM_NB_RAND);
 	return grandom;
@@ -15,11 +28,7 @@ void goom_random_free(GoomRandom *grandom) {
 
 void goom_random_update_array(GoomRandom *grandom, int numberOfValuesToChange) {
 	while (numberOfValuesToChange > 0) {
-#if RAND_MAX < 0x10000
-		grandom->array[grandom->pos++] = ((rand()<<16)+rand()) / 127;
-#else
-		grandom->array[grandom->pos++] = rand() / 127;
-#endif
+		grandom->array[grandom->pos++] = goom_random_next(grandom) / 127;
 		numberOfValuesToChange--;
 	}
 }
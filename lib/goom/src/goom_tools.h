@@ -19,9 +19,11 @@
 typedef struct _GOOM_RANDOM {
 	int array[GOOM_NB_RAND];
 	unsigned short pos;
+	unsigned int state; /* of the generator of the array, rand() is shared by all */
 } GoomRandom;
 
-GoomRandom *goom_random_init(int i);
+/* the same seed gives the same numbers */
+GoomRandom *goom_random_init(unsigned int seed);
 void goom_random_free(GoomRandom *grandom);
 
 inline static int goom_random(GoomRandom *grandom) {
@@ -6,6 +6,7 @@ typedef struct _SOUND_INFO SoundInfo;
 typedef struct _GMLINE GMLine;
 typedef struct _GMUNITPOINTER GMUnitPointer;
 typedef struct _ZOOM_FILTER_DATA ZoomFilterData;
+typedef struct _ZOOM_TRANSFORM ZoomTransform;
 typedef struct _VISUAL_FX VisualFX;
 
 #endif
@@ -6,8 +6,18 @@
 #include "goomsl_private.h"
 #include "goomsl_yacc.h"
 
+#ifndef _WIN32PC
+#include <pthread.h>
+#endif
+
 /*#define TRACE_SCRIPT*/
 
+/* the parser (flex, bison) works on currentGoomSL and globals of its own :
+ * one compilation at a time. the execution of the scripts is per GoomSL */
+#ifndef _WIN32PC
+static pthread_mutex_t compileLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
  /* {{{ definition of the instructions number */
 #define INSTR_SETI_VAR_INTEGER     1
 #define INSTR_SETI_VAR_VAR         2
@@ -58,7 +68,7 @@
 
  /* }}} */
 /* {{{ definition of the validation error types */
-static const char *VALIDATE_OK = "ok"; 
+static const char *const VALIDATE_OK = "ok";
 #define VALIDATE_ERROR "error while validating "
 #define VALIDATE_TODO "todo"
 #define VALIDATE_SYNTHAX_ERROR "synthax error"
@@ -1326,7 +1336,7 @@ static void ext_f2i(GoomSL *gsl, GoomHash *global, GoomHash *local)
 void gsl_compile(GoomSL *_currentGoomSL, const char *script)
 { /* {{{ */
   char *script_and_externals;
-  static const char *sBinds =
+  static const char *const sBinds =
     "external <charAt: string value, int index> : int\n"
     "external <f2i: float value> : int\n"
     "external <i2f: int value> : float\n";
@@ -1339,6 +1349,10 @@ void gsl_compile(GoomSL *_currentGoomSL, const char *script)
   strcpy(script_and_externals, sBinds);
   strcat(script_and_externals, script);
 
+#ifndef _WIN32PC
+  pthread_mutex_lock(&compileLock);
+#endif
+
   /* 0- reset */
   currentGoomSL = _currentGoomSL;
   reset_scanner(currentGoomSL);
@@ -1360,6 +1374,9 @@ void gsl_compile(GoomSL *_currentGoomSL, const char *script)
   gsl_bind_function(currentGoomSL, "charAt", ext_charAt);
   gsl_bind_function(currentGoomSL, "f2i", ext_f2i);
   gsl_bind_function(currentGoomSL, "i2f", ext_i2f);
+#ifndef _WIN32PC
+  pthread_mutex_unlock(&compileLock);
+#endif
   free(script_and_externals);
   
 #ifdef VERBOSE
@@ -1433,15 +1450,17 @@ void gsl_free(GoomSL *gss)
 } /* }}} */
 
 
-static int gsl_nb_import;
-static char gsl_already_imported[256][256];
+/* the files being imported, from the one asked for down to the last #import */
+typedef struct _GSL_IMPORT {
+    const char *fname;
+    const struct _GSL_IMPORT *parent;
+} GSLImport;
 
 char *gsl_init_buffer(const char *fname)
 {
     char *fbuffer;
     fbuffer = (char*)malloc(512);
     fbuffer[0]=0;
-    gsl_nb_import = 0;
     if (fname)
       gsl_append_file_to_buffer(fname,&fbuffer);
     return fbuffer;
@@ -1467,20 +1486,27 @@ static char *gsl_read_file(const char *fname)
   return buffer;
 }
 
-void gsl_append_file_to_buffer(const char *fname, char **buffer)
+/* the files already in the buffer are those of its #FILE, plus the ones being imported */
+static void gsl_append_import(const char *fname, char **buffer, const GSLImport *parent)
 {
+    const GSLImport *imp;
+    GSLImport current;
     char *fbuffer;
     int size,fsize,i=0;
     char reset_msg[256];
     
     /* look if the file have not been already imported */
-    for (i=0;i<gsl_nb_import;++i) {
-      if (strcmp(gsl_already_imported[i], fname) == 0)
+    for (imp=parent;imp;imp=imp->parent) {
+      if (strcmp(imp->fname, fname) == 0)
         return;
     }
+    snprintf(reset_msg, sizeof(reset_msg), "\n#FILE %s#\n", fname);
+    if (strstr(*buffer, reset_msg))
+      return;
     
-    /* add fname to the already imported files. */
-    strcpy(gsl_already_imported[gsl_nb_import++], fname);
+    /* add fname to the files being imported. */
+    current.fname = fname;
+    current.parent = parent;
 
     /* load the file */
     fbuffer = gsl_read_file(fname);
@@ -1498,7 +1524,7 @@ void gsl_append_file_to_buffer(const char *fname, char **buffer)
         while (fbuffer[i] && (fbuffer[i]!='\n'))
           impName[j++] = fbuffer[i++];
         impName[j++] = 0;
-        gsl_append_file_to_buffer(impName, buffer);
+        gsl_append_import(impName, buffer, &current);
       }
       i++;
     }
@@ -1511,4 +1537,9 @@ void gsl_append_file_to_buffer(const char *fname, char **buffer)
     free(fbuffer);
 }
 
+void gsl_append_file_to_buffer(const char *fname, char **buffer)
+{
+    gsl_append_import(fname, buffer, NULL);
+}
+
 
@@ -144,8 +144,20 @@ typedef struct _IFS_DATA {
 	IFSPoint *Buf;
 	int Cur_Pt;
 	int initalized;
+
+	/* colours of ifs_update, from one frame to the next */
+	int couleur;
+	int v[4];
+	int col[4];
+	int mode;
+	int justChanged;
+	int cycle;
 } IfsData;
 
+#define MOD_MER 0
+#define MOD_FEU 1
+#define MOD_MERVER 2
+
 
 /*****************************************************/
 
@@ -178,21 +190,13 @@ static DBL get_1_minus_exp_neg_S(DBL S) {
 static void
 Random_Simis (PluginInfo *goomInfo, FRACTAL * F, SIMI * Cur, int i)
 {
-	static DBL c_AS_factor;
-    static DBL r_1_minus_exp_neg_S;
-    static DBL r2_1_minus_exp_neg_S;
-	static DBL A_AS_factor;
-	static DBL A2_AS_factor;
-
-	static int doneInit = 0;
-	if (!doneInit) {
-		c_AS_factor = 0.8 * get_1_minus_exp_neg_S(4.0);
-		r_1_minus_exp_neg_S = get_1_minus_exp_neg_S(3.0);
-		r2_1_minus_exp_neg_S = get_1_minus_exp_neg_S(2.0);
-		A_AS_factor = 360.0 * get_1_minus_exp_neg_S(4.0);
-		A2_AS_factor = A_AS_factor;
-		doneInit = 1;
-	}
+	/* a few exp for all the simis, no need to keep them */
+	const DBL c_AS_factor = 0.8 * get_1_minus_exp_neg_S(4.0);
+	const DBL r_1_minus_exp_neg_S = get_1_minus_exp_neg_S(3.0);
+	const DBL r2_1_minus_exp_neg_S = get_1_minus_exp_neg_S(2.0);
+	const DBL A_AS_factor = 360.0 * get_1_minus_exp_neg_S(4.0);
+	const DBL A2_AS_factor = A_AS_factor;
+
     const DBL r_AS_factor = F->dr_mean*r_1_minus_exp_neg_S;
 	const DBL r2_AS_factor = F->dr2_mean*r2_1_minus_exp_neg_S;
 
@@ -302,7 +306,7 @@ init_ifs (PluginInfo *goomInfo, IfsData *data)
 	Fractal->Count = 0;
 	Fractal->Lx = (Fractal->Width - 1) / 2;
 	Fractal->Ly = (Fractal->Height - 1) / 2;
-	Fractal->Col = rand () % (width * height);	/* modif by JeKo */
+	Fractal->Col = NRAND (width * height);	/* modif by JeKo */
 
 	Random_Simis (goomInfo, Fractal, Fractal->Components, 5 * MAX_SIMI);
 }
@@ -492,34 +496,26 @@ static void release_ifs (IfsData *data)
 
 static void ifs_update (PluginInfo *goomInfo, Pixel * data, Pixel * back, int increment, IfsData *fx_data)
 {
-	static int couleur = 0xc0c0c0c0;
-	static int v[4] = { 2, 4, 3, 2 };
-	static int col[4] = { 2, 4, 3, 2 };
-
-#define MOD_MER 0
-#define MOD_FEU 1
-#define MOD_MERVER 2
-	static int mode = MOD_MERVER;
-	static int justChanged = 0;
-	static int cycle = 0;
+	int    *v = fx_data->v;
+	int    *col = fx_data->col;
 	int     cycle10;
 
 	int     nbpt;
 	IFSPoint *points;
 	int     i;
 
-	int     couleursl = couleur;
+	int     couleursl = fx_data->couleur;
 	int width = goomInfo->screen.width;
 	int height = goomInfo->screen.height;
 
-	cycle++;
-	if (cycle >= 80)
-		cycle = 0;
+	fx_data->cycle++;
+	if (fx_data->cycle >= 80)
+		fx_data->cycle = 0;
 
-	if (cycle < 40)
-		cycle10 = cycle / 10;
+	if (fx_data->cycle < 40)
+		cycle10 = fx_data->cycle / 10;
 	else
-		cycle10 = 7 - cycle / 10;
+		cycle10 = 7 - fx_data->cycle / 10;
 
 	{
 		unsigned char *tmp = (unsigned char *) &couleursl;
@@ -573,14 +569,14 @@ static void ifs_update (PluginInfo *goomInfo, Pixel * data, Pixel * back, int in
 		}
 	}
 #endif /*MMX*/
-		justChanged--;
+		fx_data->justChanged--;
 
-	col[ALPHA] = couleur >> (ALPHA * 8) & 0xff;
-	col[BLEU] = couleur >> (BLEU * 8) & 0xff;
-	col[VERT] = couleur >> (VERT * 8) & 0xff;
-	col[ROUGE] = couleur >> (ROUGE * 8) & 0xff;
+	col[ALPHA] = fx_data->couleur >> (ALPHA * 8) & 0xff;
+	col[BLEU] = fx_data->couleur >> (BLEU * 8) & 0xff;
+	col[VERT] = fx_data->couleur >> (VERT * 8) & 0xff;
+	col[ROUGE] = fx_data->couleur >> (ROUGE * 8) & 0xff;
 
-	if (mode == MOD_MER) {
+	if (fx_data->mode == MOD_MER) {
 		col[BLEU] += v[BLEU];
 		if (col[BLEU] > 255) {
 			col[BLEU] = 255;
@@ -627,12 +623,12 @@ static void ifs_update (PluginInfo *goomInfo, Pixel * data, Pixel * back, int in
 
 		if (((col[VERT] > 32) && (col[ROUGE] < col[VERT] + 40)
 				 && (col[VERT] < col[ROUGE] + 20) && (col[BLEU] < 64)
-				 && (RAND () % 20 == 0)) && (justChanged < 0)) {
-			mode = RAND () % 3 ? MOD_FEU : MOD_MERVER;
-			justChanged = 250;
+				 && (RAND () % 20 == 0)) && (fx_data->justChanged < 0)) {
+			fx_data->mode = RAND () % 3 ? MOD_FEU : MOD_MERVER;
+			fx_data->justChanged = 250;
 		}
 	}
-	else if (mode == MOD_MERVER) {
+	else if (fx_data->mode == MOD_MERVER) {
 		col[BLEU] += v[BLEU];
 		if (col[BLEU] > 128) {
 			col[BLEU] = 128;
@@ -679,12 +675,12 @@ static void ifs_update (PluginInfo *goomInfo, Pixel * data, Pixel * back, int in
 
 		if (((col[VERT] > 32) && (col[ROUGE] < col[VERT] + 40)
 				 && (col[VERT] < col[ROUGE] + 20) && (col[BLEU] < 64)
-				 && (RAND () % 20 == 0)) && (justChanged < 0)) {
-			mode = RAND () % 3 ? MOD_FEU : MOD_MER;
-			justChanged = 250;
+				 && (RAND () % 20 == 0)) && (fx_data->justChanged < 0)) {
+			fx_data->mode = RAND () % 3 ? MOD_FEU : MOD_MER;
+			fx_data->justChanged = 250;
 		}
 	}
-	else if (mode == MOD_FEU) {
+	else if (fx_data->mode == MOD_FEU) {
 
 		col[BLEU] += v[BLEU];
 		if (col[BLEU] > 64) {
@@ -738,13 +734,13 @@ static void ifs_update (PluginInfo *goomInfo, Pixel * data, Pixel * back, int in
 
 		if (((col[ROUGE] < 64) && (col[VERT] > 32) && (col[VERT] < col[BLEU])
 				 && (col[BLEU] > 32)
-				 && (RAND () % 20 == 0)) && (justChanged < 0)) {
-			mode = RAND () % 2 ? MOD_MER : MOD_MERVER;
-			justChanged = 250;
+				 && (RAND () % 20 == 0)) && (fx_data->justChanged < 0)) {
+			fx_data->mode = RAND () % 2 ? MOD_MER : MOD_MERVER;
+			fx_data->justChanged = 250;
 		}
 	}
 
-	couleur = (col[ALPHA] << (ALPHA * 8))
+	fx_data->couleur = (col[ALPHA] << (ALPHA * 8))
 		| (col[BLEU] << (BLEU * 8))
 		| (col[VERT] << (VERT * 8))
 		| (col[ROUGE] << (ROUGE * 8));
@@ -768,6 +764,14 @@ static void ifs_vfx_init(VisualFX *_this, PluginInfo *info) {
 	IfsData *data = (IfsData*)malloc(sizeof(IfsData));
 	data->Root = (FRACTAL*)NULL;
 	data->initalized = 0;
+	data->couleur = 0xc0c0c0c0;
+	data->v[0] = data->col[0] = 2;
+	data->v[1] = data->col[1] = 4;
+	data->v[2] = data->col[2] = 3;
+	data->v[3] = data->col[3] = 2;
+	data->mode = MOD_MERVER;
+	data->justChanged = 0;
+	data->cycle = 0;
 	_this->fx_data = data;
 }
 
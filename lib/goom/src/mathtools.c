@@ -10,7 +10,7 @@
 
 #include "mathtools.h"
 
-float sin256[256] = {
+const float sin256[256] = {
   0,0.0245412,0.0490677,0.0735646,0.0980171,0.122411,0.14673,0.170962
   ,0.19509,0.219101,0.24298,0.266713,0.290285,0.313682,0.33689,0.359895
   ,0.382683,0.405241,0.427555,0.449611,0.471397,0.492898,0.514103,0.534998
@@ -46,7 +46,7 @@ float sin256[256] = {
 
 };
 
-float cos256[256] = {
+const float cos256[256] = {
   0,0.999699,0.998795,0.99729,0.995185,0.99248,0.989177,0.985278
   ,0.980785,0.975702,0.970031,0.963776,0.95694,0.949528,0.941544,0.932993
   ,0.92388,0.91421,0.903989,0.893224,0.881921,0.870087,0.857729,0.844854
@@ -29,8 +29,8 @@
 #define SINCOS(f,s,c) {s=sin(f);c=cos(f);}
 #endif
 
-extern float sin256[256];
-extern float cos256[256];
+extern const float sin256[256];
+extern const float cos256[256];
 
 #endif
 
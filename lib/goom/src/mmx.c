@@ -6,6 +6,7 @@
 
 #include "mmx.h"
 #include "goom_graphic.h"
+#include "goom_filters.h"
 
 #define sqrtperte 16
 // faire : a % sqrtperte <=> a & pertemask
@@ -17,32 +18,30 @@ int mmx_supported (void) {
 	return (mm_support()&0x1);
 }
 
-void zoom_filter_mmx (int prevX, int prevY,
+void zoom_filter_mmx (int prevX, int prevY, int start, int end,
 		      Pixel *expix1, Pixel *expix2,
-		      int *brutS, int *brutD, int buffratio,
+		      const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio,
 		      int precalCoef[16][16])
 {
 	unsigned int ax = (prevX-1)<<PERTEDEC, ay = (prevY-1)<<PERTEDEC;
 
-	int bufsize = prevX * prevY;
+	int bufend = end;
 	int loop;
 
 	__asm__ __volatile__ ("pxor %mm7,%mm7");
 
-	for (loop=0; loop<bufsize; loop++)
+	for (loop=start; loop<bufend; loop++)
 	{
 		/*      int couleur; */
 		int px,py;
 		int pos;
 		int coeffs;
 
-		int myPos = loop << 1,
-		myPos2 = myPos + 1;
-		int brutSmypos = brutS[myPos];
+		int brutSmypos = brutS->x[loop];
 
-		px = brutSmypos + (((brutD[myPos] - brutSmypos)*buffratio) >> BUFFPOINTNB);
-		brutSmypos = brutS[myPos2];
-		py = brutSmypos + (((brutD[myPos2] - brutSmypos)*buffratio) >> BUFFPOINTNB);
+		px = brutSmypos + (((brutD->x[loop] - brutSmypos)*buffratio) >> BUFFPOINTNB);
+		brutSmypos = brutS->y[loop];
+		py = brutSmypos + (((brutD->y[loop] - brutSmypos)*buffratio) >> BUFFPOINTNB);
 
 		if ((py>=ay) || (px>=ax)) {
 			pos=coeffs=0;
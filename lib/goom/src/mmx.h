@@ -28,6 +28,7 @@
 #define _MMX_H
 
 #include "goom_graphic.h"
+#include "goom_typedefs.h"
 
 /*	Warning:  at this writing, the version of GAS packaged
 	with most Linux distributions does not handle the
@@ -241,10 +242,10 @@ int xmmx_supported (void);
 /* MMX optimized implementations */
 void draw_line_mmx (Pixel *data, int x1, int y1, int x2, int y2, int col, int screenx, int screeny);
 void draw_line_xmmx (Pixel *data, int x1, int y1, int x2, int y2, int col, int screenx, int screeny);
-void zoom_filter_mmx (int prevX, int prevY, Pixel *expix1, Pixel *expix2,
-		      int *brutS, int *brutD, int buffratio, int precalCoef[16][16]);
-void zoom_filter_xmmx (int prevX, int prevY, Pixel *expix1, Pixel *expix2,
-                       int *lbruS, int *lbruD, int buffratio, int precalCoef[16][16]);
+void zoom_filter_mmx (int prevX, int prevY, int start, int end, Pixel *expix1, Pixel *expix2,
+		      const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16]);
+void zoom_filter_xmmx (int prevX, int prevY, int start, int end, Pixel *expix1, Pixel *expix2,
+                       const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16]);
 
 
 /*	Helper functions for the instruction macros that follow...
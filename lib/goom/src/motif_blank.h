@@ -1,4 +1,4 @@
-static Motif CONV_MOTIF_BLANK = {
+static const Motif CONV_MOTIF_BLANK = {
 	15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,
 	15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,
 	15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,
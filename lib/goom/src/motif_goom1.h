@@ -1,4 +1,4 @@
-static Motif CONV_MOTIF1 = {
+static const Motif CONV_MOTIF1 = {
 	15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,
 	15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,
 	15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,
@@ -1,4 +1,4 @@
-static Motif CONV_MOTIF2 = {
+static const Motif CONV_MOTIF2 = {
 	15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,
 	15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,
 	15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,
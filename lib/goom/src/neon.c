@@ -0,0 +1,81 @@
+/*
+ *  neon.c
+ *  Goom
+ *
+ *  NEON versions of the output of convolve_fx : 4 pixels per loop.
+ */
+
+#ifdef HAVE_NEON
+
+#include <arm_neon.h>
+
+#include "simd.h"
+
+/* the 4 pixels times their iff >> 8, saturated to 16 then 8 bits, without alpha */
+static inline uint8x16_t brighten4 (uint8x16_t px, const uint16_t iff[4])
+{
+    uint16x8_t lo = vmovl_u8 (vget_low_u8 (px));
+    uint16x8_t hi = vmovl_u8 (vget_high_u8 (px));
+    Pixel alpha;
+
+    alpha.val = 0;
+    alpha.channels.a = 0xff;
+    lo = vcombine_u16 (vqshrn_n_u32 (vmull_u16 (vget_low_u16 (lo), vdup_n_u16 (iff[0])), 8),
+                       vqshrn_n_u32 (vmull_u16 (vget_high_u16 (lo), vdup_n_u16 (iff[1])), 8));
+    hi = vcombine_u16 (vqshrn_n_u32 (vmull_u16 (vget_low_u16 (hi), vdup_n_u16 (iff[2])), 8),
+                       vqshrn_n_u32 (vmull_u16 (vget_high_u16 (hi), vdup_n_u16 (iff[3])), 8));
+    return vandq_u8 (vcombine_u8 (vqmovn_u16 (lo), vqmovn_u16 (hi)),
+                     vreinterpretq_u8_u32 (vdupq_n_u32 (~alpha.val)));
+}
+
+/* above 0xffff, any channel but 0 saturates anyway */
+static inline uint16_t iff16 (int iff)
+{
+    return (iff > 0xffff) ? 0xffff : (uint16_t)iff;
+}
+
+/* same result than create_output_with_brightness_c */
+void create_output_with_brightness_neon (Pixel *src, Pixel *dest, int n, int xtex, int ytex, int c, int s,
+                                         const int *texture)
+{
+    const int32x4_t wMask = vdupq_n_s32 (CONV_MOTIF_WMASK);
+    const int32x4_t dx = vdupq_n_s32 (4 * c);
+    const int32x4_t dy = vdupq_n_s32 (4 * s);
+    const int steps[4] = {1, 2, 3, 4};
+    int32x4_t tx = vmlaq_n_s32 (vdupq_n_s32 (xtex), vld1q_s32 (steps), c);
+    int32x4_t ty = vmlsq_n_s32 (vdupq_n_s32 (ytex), vld1q_s32 (steps), s);
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        int idxA[4];
+        uint16_t iff[4];
+        int k;
+
+        vst1q_s32 (idxA, vorrq_s32 (vshlq_n_s32 (vandq_s32 (vshrq_n_s32 (ty, 16), wMask), 7),
+                                    vandq_s32 (vshrq_n_s32 (tx, 16), wMask)));
+        for (k = 0; k < 4; ++k)
+            iff[k] = iff16 (texture[idxA[k]]);
+        vst1q_u8 ((uint8_t*)(dest + i), brighten4 (vld1q_u8 ((const uint8_t*)(src + i)), iff));
+
+        tx = vaddq_s32 (tx, dx);
+        ty = vsubq_s32 (ty, dy);
+    }
+
+    if (i < n)
+        create_output_with_brightness_c (src + i, dest + i, n - i, xtex + i * c, ytex - i * s, c, s, texture);
+}
+
+/* same result than create_output_with_uniform_brightness_c */
+void create_output_with_uniform_brightness_neon (Pixel *src, Pixel *dest, int n, int iff)
+{
+    const uint16_t iffA[4] = {iff16 (iff), iff16 (iff), iff16 (iff), iff16 (iff)};
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4)
+        vst1q_u8 ((uint8_t*)(dest + i), brighten4 (vld1q_u8 ((const uint8_t*)(src + i)), iffA));
+
+    if (i < n)
+        create_output_with_uniform_brightness_c (src + i, dest + i, n - i, iff);
+}
+
+#endif /* HAVE_NEON */
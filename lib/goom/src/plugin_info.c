@@ -8,28 +8,25 @@
 #include <stdio.h>
 
 
-#ifdef CPU_POWERPC
-#include <sys/types.h>
-#include <sys/sysctl.h>
-#include "ppc_zoom_ultimate.h"
-#include "ppc_drawings.h"
-#endif /* CPU_POWERPC */
-
-
 #ifdef CPU_X86
 #include "mmx.h"
 #endif /* CPU_X86 */
 
+#if defined(HAVE_SSE2) || defined(HAVE_AVX2) || defined(HAVE_NEON)
+#include "simd.h"
+#endif
 
 
-static void setOptimizedMethods(PluginInfo *p) {
 
-    unsigned int cpuFlavour = cpu_flavour();
+static void setOptimizedMethods(PluginInfo *p, unsigned int cpuFlavour) {
 
     /* set default methods */
     p->methods.draw_line = draw_line;
     p->methods.zoom_filter = zoom_filter_c;
-/*    p->methods.create_output_with_brightness = create_output_with_brightness;*/
+    p->methods.zoom_filter_exact = zoom_filter_c;
+    p->methods.zoom_filter_steady = zoom_filter_steady_c;
+    p->methods.create_output_with_brightness = create_output_with_brightness_c;
+    p->methods.create_output_with_uniform_brightness = create_output_with_uniform_brightness_c;
 
 #ifdef CPU_X86
 	if (cpuFlavour & CPU_OPTION_XMMX) {
@@ -51,23 +48,43 @@ static void setOptimizedMethods(PluginInfo *p) {
             printf ("Too bad ! No SIMD optimization available for your CPU.\n");
 #endif
 #endif /* CPU_X86 */
-	
-#ifdef CPU_POWERPC
-
-        if ((cpuFlavour & CPU_OPTION_64_BITS) != 0) {
-/*            p->methods.create_output_with_brightness = ppc_brightness_G5;        */
-            p->methods.zoom_filter = ppc_zoom_generic;
-        }
-        else if ((cpuFlavour & CPU_OPTION_ALTIVEC) != 0) {
-/*            p->methods.create_output_with_brightness = ppc_brightness_G4;        */
-            p->methods.zoom_filter = ppc_zoom_G4;
-        }
-        else
-        {
-/*            p->methods.create_output_with_brightness = ppc_brightness_generic;*/
-            p->methods.zoom_filter = ppc_zoom_generic;
-        }        
-#endif /* CPU_POWERPC */
+
+#ifdef HAVE_SSE2
+	if (cpuFlavour & CPU_OPTION_SSE2) {
+#ifdef VERBOSE
+		printf ("SSE2 detected. Using fast methods !\n");
+#endif
+		p->methods.zoom_filter = zoom_filter_sse2;
+		p->methods.zoom_filter_exact = zoom_filter_sse2_exact;
+		p->methods.zoom_filter_steady = zoom_filter_steady_sse2;
+		p->methods.create_output_with_brightness = create_output_with_brightness_sse2;
+		p->methods.create_output_with_uniform_brightness = create_output_with_uniform_brightness_sse2;
+	}
+#endif /* HAVE_SSE2 */
+
+#ifdef HAVE_AVX2
+	/* better than sse2 when available */
+	if (cpuFlavour & CPU_OPTION_AVX2) {
+#ifdef VERBOSE
+		printf ("AVX2 detected. Using the fastest methods !\n");
+#endif
+		p->methods.zoom_filter = zoom_filter_avx2;
+		p->methods.zoom_filter_exact = zoom_filter_avx2_exact;
+		p->methods.zoom_filter_steady = zoom_filter_steady_avx2;
+		p->methods.create_output_with_brightness = create_output_with_brightness_avx2;
+		p->methods.create_output_with_uniform_brightness = create_output_with_uniform_brightness_avx2;
+	}
+#endif /* HAVE_AVX2 */
+
+#ifdef HAVE_NEON
+	if (cpuFlavour & CPU_OPTION_NEON) {
+#ifdef VERBOSE
+		printf ("NEON detected. Using fast methods !\n");
+#endif
+		p->methods.create_output_with_brightness = create_output_with_brightness_neon;
+		p->methods.create_output_with_uniform_brightness = create_output_with_uniform_brightness_neon;
+	}
+#endif /* HAVE_NEON */
 
 }
 
@@ -79,7 +96,11 @@ void plugin_info_init(PluginInfo *pp, int nbVisuals) {
 	p.sound.speedvar = p.sound.accelvar = p.sound.totalgoom = 0;
     p.sound.prov_max = 0;
 	p.sound.goom_limit = 1;
+	p.sound.bigGoomLimit = 1;
 	p.sound.allTimesMax = 1;
+	p.sound.timeSinceLastGoom = p.sound.timeSinceLastBigGoom = 0;
+	p.sound.goomPower = 0;
+	p.sound.cycle = 0;
 
 	p.sound.volume_p       = secure_f_feedback("Sound Volume");
 	p.sound.accel_p        = secure_f_feedback("Sound Acceleration");
@@ -161,6 +182,11 @@ void plugin_info_init(PluginInfo *pp, int nbVisuals) {
 
 	pp->update_message.affiche = 0;
 
+	pp->zoomBandHook = NULL;
+	pp->overlay.record = 0;
+	pp->overlay.nb = pp->overlay.max = 0;
+	pp->overlay.rects = NULL;
+
 	{
 		ZoomFilterData zfd = {
 			127, 8, 16,
@@ -170,7 +196,7 @@ void plugin_info_init(PluginInfo *pp, int nbVisuals) {
 		pp->update.zoomFilterData = zfd;
 	}
 	
-	setOptimizedMethods(pp);
+	setOptimizedMethods(pp, cpu_flavour());
 	
     pp->scanner = gsl_new();
     pp->main_scanner = gsl_new();
@@ -182,6 +208,10 @@ void plugin_info_init(PluginInfo *pp, int nbVisuals) {
 	}
 }
 
+void plugin_info_set_cpu_flavour(PluginInfo *p, unsigned int cpuFlavour) {
+	setOptimizedMethods(p, cpuFlavour & cpu_flavour());
+}
+
 void plugin_info_add_visual(PluginInfo *p, int i, VisualFX *visual) {
 	p->visuals[i] = visual;
 	if (i == p->nbVisuals-1) {
@@ -201,3 +231,41 @@ void plugin_info_add_visual(PluginInfo *p, int i, VisualFX *visual) {
 		}
 	}  
 }
+
+void plugin_info_overlay_rect(PluginInfo *p, int x0, int y0, int x1, int y1) {
+	GoomRect *r;
+
+	if (!p->overlay.record) return;
+	if (x0 < 0) x0 = 0;
+	if (y0 < 0) y0 = 0;
+	if (x1 > p->screen.width) x1 = p->screen.width;
+	if (y1 > p->screen.height) y1 = p->screen.height;
+	if ((x0 >= x1) || (y0 >= y1)) return;
+
+	if (p->overlay.nb == p->overlay.max) {
+		GoomRect *rects;
+		int max = p->overlay.max ? 2 * p->overlay.max : 256;
+		rects = (GoomRect *)realloc(p->overlay.rects, max * sizeof(GoomRect));
+		if (rects == NULL)
+			return;
+		p->overlay.rects = rects;
+		p->overlay.max = max;
+	}
+	r = &p->overlay.rects[p->overlay.nb++];
+	r->x0 = x0; r->y0 = y0;
+	r->x1 = x1; r->y1 = y1;
+}
+
+void plugin_info_overlay_line(PluginInfo *p, int x1, int y1, int x2, int y2) {
+	int xmin = (x1 < x2) ? x1 : x2, xmax = (x1 < x2) ? x2 : x1;
+	int ymin = (y1 < y2) ? y1 : y2, ymax = (y1 < y2) ? y2 : y1;
+
+	if (!p->overlay.record) return;
+	/* same test as draw_line, nothing is drawn */
+	if ((xmin < 0) || (ymin < 0) || (xmax >= p->screen.width) || (ymax >= p->screen.height)) return;
+
+	/* the steep lines may also touch the pixel at the right of the end */
+	plugin_info_overlay_rect(p, xmin, ymin, xmax + 2, ymax + 1);
+	if (xmax + 1 >= p->screen.width)
+		plugin_info_overlay_rect(p, 0, ymin + 1, 1, ymax + 2);
+}
@@ -0,0 +1,93 @@
+#ifndef _GOOM_SIMD_H
+#define _GOOM_SIMD_H
+
+/*
+ * Intrinsics based versions of the goom methods.
+ *
+ * HAVE_SSE2 / HAVE_AVX2 / HAVE_NEON are set by the build when the files are compiled in,
+ * the methods are then selected at runtime by setOptimizedMethods (cf cpu_flavour).
+ *
+ * The _exact versions give exactly the same result as the C versions.
+ * The others are allowed to be a little bit different to go faster.
+ */
+
+#include "goom_config.h"
+#include "goom_graphic.h"
+#include "goom_filters.h"
+#include "goom_fx.h"
+
+/* the 4 source pixels from pos, weighted by coeffs, the alpha of dest is kept */
+static inline Pixel zoom_blend_c (int prevX, const Pixel *expix1, int pos, int coeffs, Pixel dest)
+{
+    unsigned int c[4], i, r = 0, g = 0, b = 0;
+
+    for (i = 0; i < 4; ++i) {
+        Pixel col = expix1[pos + (i & 1) + (i >> 1) * prevX];
+        c[i] = (coeffs >> (8 * i)) & 0xff;
+        r += col.channels.r * c[i];
+        g += col.channels.g * c[i];
+        b += col.channels.b * c[i];
+    }
+    dest.channels.r = ((r > 5) ? r - 5 : r) >> 8;
+    dest.channels.g = ((g > 5) ? g - 5 : g) >> 8;
+    dest.channels.b = ((b > 5) ? b - 5 : b) >> 8;
+    return dest;
+}
+
+/* computes the pixel myPos of the zoom like c_zoom does.
+ * used for the last pixels of a band, when there is not enough left to fill a vector. */
+static inline Pixel zoom_pixel_c (int prevX, int prevY, int myPos, Pixel *expix1, Pixel dest,
+                                  const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16])
+{
+    unsigned int ax = (prevX - 1) << 4, ay = (prevY - 1) << 4;
+    int px, py, pos = 0, coeffs = 0;
+
+    px = brutS->x[myPos] + (((brutD->x[myPos] - brutS->x[myPos]) * buffratio) >> 16);
+    py = brutS->y[myPos] + (((brutD->y[myPos] - brutS->y[myPos]) * buffratio) >> 16);
+
+    if (((unsigned int)py < ay) && ((unsigned int)px < ax)) {
+        pos = (px >> 4) + prevX * (py >> 4);
+        coeffs = precalCoef[px & 0xf][py & 0xf];
+    }
+    return zoom_blend_c (prevX, expix1, pos, coeffs, dest);
+}
+
+/* same as zoom_pixel_c, from the collapsed transform */
+static inline Pixel zoom_steady_pixel_c (int prevX, int myPos, Pixel *expix1, Pixel dest,
+                                         const guint32 *steady, const int coefs[ZOOM_STEADY_NB_COEFS])
+{
+    return zoom_blend_c (prevX, expix1, steady[myPos] >> ZOOM_STEADY_COEF_BITS,
+                         coefs[steady[myPos] & ZOOM_STEADY_COEF_MASK], dest);
+}
+
+#ifdef HAVE_SSE2
+void zoom_filter_sse2 (int prevX, int prevY, int start, int end, Pixel *expix1, Pixel *expix2,
+                       const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16]);
+void zoom_filter_sse2_exact (int prevX, int prevY, int start, int end, Pixel *expix1, Pixel *expix2,
+                             const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16]);
+void zoom_filter_steady_sse2 (int prevX, int start, int end, Pixel *expix1, Pixel *expix2,
+                              const guint32 *steady, const int coefs[ZOOM_STEADY_NB_COEFS]);
+void create_output_with_brightness_sse2 (Pixel *src, Pixel *dest, int n, int xtex, int ytex, int c, int s,
+                                         const int *texture);
+void create_output_with_uniform_brightness_sse2 (Pixel *src, Pixel *dest, int n, int iff);
+#endif /* HAVE_SSE2 */
+
+#ifdef HAVE_AVX2
+void zoom_filter_avx2 (int prevX, int prevY, int start, int end, Pixel *expix1, Pixel *expix2,
+                       const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16]);
+void zoom_filter_avx2_exact (int prevX, int prevY, int start, int end, Pixel *expix1, Pixel *expix2,
+                             const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16]);
+void zoom_filter_steady_avx2 (int prevX, int start, int end, Pixel *expix1, Pixel *expix2,
+                              const guint32 *steady, const int coefs[ZOOM_STEADY_NB_COEFS]);
+void create_output_with_brightness_avx2 (Pixel *src, Pixel *dest, int n, int xtex, int ytex, int c, int s,
+                                         const int *texture);
+void create_output_with_uniform_brightness_avx2 (Pixel *src, Pixel *dest, int n, int iff);
+#endif /* HAVE_AVX2 */
+
+#ifdef HAVE_NEON
+void create_output_with_brightness_neon (Pixel *src, Pixel *dest, int n, int xtex, int ytex, int c, int s,
+                                         const int *texture);
+void create_output_with_uniform_brightness_neon (Pixel *src, Pixel *dest, int n, int iff);
+#endif /* HAVE_NEON */
+
+#endif
@@ -0,0 +1,267 @@
+/*
+ *  sse2.c
+ *  Goom
+ *
+ *  SSE2 versions of the zoom filter and of the output of convolve_fx : 4 pixels per loop.
+ */
+
+#ifdef HAVE_SSE2
+
+#include <emmintrin.h>
+
+#include "simd.h"
+
+/* 32 bits a*b (low part), SSE2 only knows the unsigned 32x32->64 one */
+static inline __m128i mullo_epi32 (__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32 (a, b);
+    __m128i odd  = _mm_mul_epu32 (_mm_srli_epi64 (a, 32), _mm_srli_epi64 (b, 32));
+    return _mm_unpacklo_epi32 (_mm_shuffle_epi32 (even, _MM_SHUFFLE (0,0,2,0)),
+                               _mm_shuffle_epi32 (odd,  _MM_SHUFFLE (0,0,2,0)));
+}
+
+/* S + (D-S)*buffratio for 4 positions */
+static inline __m128i interpolate (const gint16 *brutS, const gint16 *brutD, __m128i ratio)
+{
+    __m128i s = _mm_loadl_epi64 ((const __m128i*)brutS);
+    __m128i d = _mm_loadl_epi64 ((const __m128i*)brutD);
+    /* sign extension to 32 bits */
+    s = _mm_srai_epi32 (_mm_unpacklo_epi16 (s, s), 16);
+    d = _mm_srai_epi32 (_mm_unpacklo_epi16 (d, d), 16);
+    return _mm_add_epi32 (s, _mm_srai_epi32 (mullo_epi32 (_mm_sub_epi32 (d, s), ratio), 16));
+}
+
+/* [a0 b0 a1 b1] [a2 b2 a3 b3] -> [a0 a1 a2 a3] [b0 b1 b2 b3] */
+static inline void deinterleave (__m128i lo, __m128i hi, __m128i *a, __m128i *b)
+{
+    lo = _mm_shuffle_epi32 (lo, _MM_SHUFFLE (3,1,2,0));
+    hi = _mm_shuffle_epi32 (hi, _MM_SHUFFLE (3,1,2,0));
+    *a = _mm_unpacklo_epi64 (lo, hi);
+    *b = _mm_unpackhi_epi64 (lo, hi);
+}
+
+/* r,b (or g,a) channels of the 4 pixels, times the coeff of each pixel */
+static inline __m128i weight (__m128i col, __m128i coeffs, int shift)
+{
+    __m128i c = _mm_and_si128 (_mm_srli_epi32 (coeffs, shift), _mm_set1_epi32 (0xff));
+    c = _mm_or_si128 (c, _mm_slli_epi32 (c, 16));
+    return _mm_mullo_epi16 (col, c);
+}
+
+/* the 4 neighbours of the 4 positions, weighted by their coeffs */
+static inline __m128i blend4 (const Pixel *expix1, int prevX, const int *posA, __m128i coeffs)
+{
+    const __m128i lowBytes = _mm_set1_epi32 (0x00ff00ff);
+    const __m128i bias = _mm_set1_epi16 (5);
+    __m128i col[4], top[2], bot[2], rb, ga;
+    int i;
+
+    /* two by two */
+    for (i = 0; i < 2; ++i) {
+        top[i] = _mm_unpacklo_epi64 (_mm_loadl_epi64 ((const __m128i*)(expix1 + posA[2*i])),
+                                     _mm_loadl_epi64 ((const __m128i*)(expix1 + posA[2*i+1])));
+        bot[i] = _mm_unpacklo_epi64 (_mm_loadl_epi64 ((const __m128i*)(expix1 + posA[2*i] + prevX)),
+                                     _mm_loadl_epi64 ((const __m128i*)(expix1 + posA[2*i+1] + prevX)));
+    }
+    deinterleave (top[0], top[1], &col[0], &col[1]);
+    deinterleave (bot[0], bot[1], &col[2], &col[3]);
+
+    rb = ga = _mm_setzero_si128 ();
+    for (i = 0; i < 4; ++i) {
+        rb = _mm_add_epi16 (rb, weight (_mm_and_si128 (col[i], lowBytes), coeffs, 8*i));
+        ga = _mm_add_epi16 (ga, weight (_mm_and_si128 (_mm_srli_epi32 (col[i], 8), lowBytes), coeffs, 8*i));
+    }
+    rb = _mm_srli_epi16 (_mm_subs_epu16 (rb, bias), 8);
+    ga = _mm_srli_epi16 (_mm_subs_epu16 (ga, bias), 8);
+    return _mm_or_si128 (rb, _mm_slli_epi16 (ga, 8));
+}
+
+/* the C version does not touch the alpha channel of the dest */
+static inline __m128i alpha_mask (void)
+{
+    Pixel alpha;
+    alpha.val = 0;
+    alpha.channels.a = 0xff;
+    return _mm_set1_epi32 ((int)alpha.val);
+}
+
+static inline void zoom_filter_sse2_ (int prevX, int prevY, int start, int end,
+                                      Pixel *expix1, Pixel *expix2,
+                                      const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio,
+                                      int precalCoef[16][16], int exact)
+{
+    const __m128i signBit = _mm_set1_epi32 ((int)0x80000000);
+    const __m128i ax = _mm_xor_si128 (_mm_set1_epi32 ((prevX - 1) << 4), signBit);
+    const __m128i ay = _mm_xor_si128 (_mm_set1_epi32 ((prevY - 1) << 4), signBit);
+    const __m128i ratio = _mm_set1_epi32 (buffratio);
+    const __m128i width = _mm_set1_epi32 (prevX);
+    const __m128i alphaMask = alpha_mask ();
+    const int *coefs = &precalCoef[0][0];
+
+    int myPos = start;
+    int bufend = end;
+
+    for (; myPos + 4 <= bufend; myPos += 4) {
+        __m128i d, px, py, valid, pos, idx, coeffs;
+#ifdef _MSC_VER
+        __declspec(align(16)) int posA[4], idxA[4];
+#else
+        int posA[4] __attribute__ ((aligned (16))), idxA[4] __attribute__ ((aligned (16)));
+#endif
+
+        px = interpolate (brutS->x + myPos, brutD->x + myPos, ratio);
+        py = interpolate (brutS->y + myPos, brutD->y + myPos, ratio);
+
+        /* unsigned px < ax && py < ay, the others point at pixel 0 with null coeffs */
+        valid = _mm_and_si128 (_mm_cmplt_epi32 (_mm_xor_si128 (px, signBit), ax),
+                               _mm_cmplt_epi32 (_mm_xor_si128 (py, signBit), ay));
+        px = _mm_and_si128 (px, valid);
+        py = _mm_and_si128 (py, valid);
+
+        /* py>>4 and prevX both fit on 16 bits */
+        pos = _mm_add_epi32 (_mm_srli_epi32 (px, 4), _mm_madd_epi16 (_mm_srli_epi32 (py, 4), width));
+        idx = _mm_or_si128 (_mm_slli_epi32 (_mm_and_si128 (px, _mm_set1_epi32 (0xf)), 4),
+                            _mm_and_si128 (py, _mm_set1_epi32 (0xf)));
+        _mm_store_si128 ((__m128i*)posA, pos);
+        _mm_store_si128 ((__m128i*)idxA, idx);
+
+        coeffs = _mm_and_si128 (_mm_setr_epi32 (coefs[idxA[0]], coefs[idxA[1]], coefs[idxA[2]], coefs[idxA[3]]), valid);
+
+        d = blend4 (expix1, prevX, posA, coeffs);
+
+        if (exact) {
+            __m128i old = _mm_loadu_si128 ((__m128i*)(expix2 + myPos));
+            d = _mm_or_si128 (_mm_andnot_si128 (alphaMask, d), _mm_and_si128 (alphaMask, old));
+        }
+        _mm_storeu_si128 ((__m128i*)(expix2 + myPos), d);
+    }
+
+    for (; myPos < bufend; ++myPos)
+        expix2[myPos] = zoom_pixel_c (prevX, prevY, myPos, expix1, expix2[myPos],
+                                      brutS, brutD, buffratio, precalCoef);
+}
+
+/* the alpha channel gets the zoomed alpha of the source */
+void zoom_filter_sse2 (int prevX, int prevY, int start, int end, Pixel *expix1, Pixel *expix2,
+                       const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16])
+{
+    zoom_filter_sse2_ (prevX, prevY, start, end, expix1, expix2, brutS, brutD, buffratio, precalCoef, 0);
+}
+
+/* same result than zoom_filter_c */
+void zoom_filter_sse2_exact (int prevX, int prevY, int start, int end, Pixel *expix1, Pixel *expix2,
+                             const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio, int precalCoef[16][16])
+{
+    zoom_filter_sse2_ (prevX, prevY, start, end, expix1, expix2, brutS, brutD, buffratio, precalCoef, 1);
+}
+
+/* same result than zoom_filter_sse2_exact, the positions and coeffs are already there */
+void zoom_filter_steady_sse2 (int prevX, int start, int end, Pixel *expix1, Pixel *expix2,
+                              const guint32 *steady, const int coefs[ZOOM_STEADY_NB_COEFS])
+{
+    const __m128i coefMask = _mm_set1_epi32 (ZOOM_STEADY_COEF_MASK);
+    const __m128i alphaMask = alpha_mask ();
+
+    int myPos = start;
+    int bufend = end;
+
+    for (; myPos + 4 <= bufend; myPos += 4) {
+        __m128i w, d, old;
+#ifdef _MSC_VER
+        __declspec(align(16)) int posA[4], idxA[4];
+#else
+        int posA[4] __attribute__ ((aligned (16))), idxA[4] __attribute__ ((aligned (16)));
+#endif
+
+        w = _mm_loadu_si128 ((const __m128i*)(steady + myPos));
+        _mm_store_si128 ((__m128i*)posA, _mm_srli_epi32 (w, ZOOM_STEADY_COEF_BITS));
+        _mm_store_si128 ((__m128i*)idxA, _mm_and_si128 (w, coefMask));
+
+        d = blend4 (expix1, prevX, posA, _mm_setr_epi32 (coefs[idxA[0]], coefs[idxA[1]], coefs[idxA[2]], coefs[idxA[3]]));
+
+        old = _mm_loadu_si128 ((__m128i*)(expix2 + myPos));
+        d = _mm_or_si128 (_mm_andnot_si128 (alphaMask, d), _mm_and_si128 (alphaMask, old));
+        _mm_storeu_si128 ((__m128i*)(expix2 + myPos), d);
+    }
+
+    for (; myPos < bufend; ++myPos)
+        expix2[myPos] = zoom_steady_pixel_c (prevX, myPos, expix1, expix2[myPos], steady, coefs);
+}
+
+/* min (a, 255) for unsigned 16 bits, SSE2 has no min_epu16 */
+static inline __m128i min255 (__m128i a)
+{
+    return _mm_sub_epi16 (a, _mm_subs_epu16 (a, _mm_set1_epi16 (0xff)));
+}
+
+/* iff (32 bits) as [iff iff] 16 bits, above 0xffff any channel but 0 saturates anyway */
+static inline __m128i iff16 (__m128i iff)
+{
+    const __m128i maxIff = _mm_set1_epi32 (0xffff);
+    __m128i over = _mm_cmpgt_epi32 (iff, maxIff);
+    iff = _mm_or_si128 (_mm_andnot_si128 (over, iff), _mm_and_si128 (over, maxIff));
+    return _mm_or_si128 (iff, _mm_slli_epi32 (iff, 16));
+}
+
+/* the 4 pixels times their iff16 >> 8, saturated, without alpha */
+static inline __m128i brighten4 (__m128i px, __m128i iff)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i noAlpha = _mm_xor_si128 (alpha_mask (), _mm_set1_epi32 (-1));
+    /* (c << 8) * iff >> 16 == c * iff >> 8 */
+    __m128i lo = min255 (_mm_mulhi_epu16 (_mm_unpacklo_epi8 (zero, px), _mm_unpacklo_epi32 (iff, iff)));
+    __m128i hi = min255 (_mm_mulhi_epu16 (_mm_unpackhi_epi8 (zero, px), _mm_unpackhi_epi32 (iff, iff)));
+    return _mm_and_si128 (_mm_packus_epi16 (lo, hi), noAlpha);
+}
+
+/* same result than create_output_with_brightness_c */
+void create_output_with_brightness_sse2 (Pixel *src, Pixel *dest, int n, int xtex, int ytex, int c, int s,
+                                         const int *texture)
+{
+    const __m128i wMask = _mm_set1_epi32 (CONV_MOTIF_WMASK);
+    const __m128i dx = _mm_set1_epi32 (4 * c);
+    const __m128i dy = _mm_set1_epi32 (4 * s);
+    __m128i tx = _mm_setr_epi32 (xtex + c, xtex + 2*c, xtex + 3*c, xtex + 4*c);
+    __m128i ty = _mm_setr_epi32 (ytex - s, ytex - 2*s, ytex - 3*s, ytex - 4*s);
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i idx, iff;
+#ifdef _MSC_VER
+        __declspec(align(16)) int idxA[4];
+#else
+        int idxA[4] __attribute__ ((aligned (16)));
+#endif
+
+        idx = _mm_or_si128 (_mm_slli_epi32 (_mm_and_si128 (_mm_srai_epi32 (ty, 16), wMask), 7),
+                            _mm_and_si128 (_mm_srai_epi32 (tx, 16), wMask));
+        _mm_store_si128 ((__m128i*)idxA, idx);
+        iff = iff16 (_mm_setr_epi32 (texture[idxA[0]], texture[idxA[1]], texture[idxA[2]], texture[idxA[3]]));
+        _mm_storeu_si128 ((__m128i*)(dest + i), brighten4 (_mm_loadu_si128 ((const __m128i*)(src + i)), iff));
+
+        tx = _mm_add_epi32 (tx, dx);
+        ty = _mm_sub_epi32 (ty, dy);
+    }
+
+    if (i < n)
+        create_output_with_brightness_c (src + i, dest + i, n - i, xtex + i * c, ytex - i * s, c, s, texture);
+}
+
+/* same result than create_output_with_uniform_brightness_c */
+void create_output_with_uniform_brightness_sse2 (Pixel *src, Pixel *dest, int n, int iff)
+{
+    const __m128i iffV = iff16 (_mm_set1_epi32 (iff));
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_loadu_si128 ((const __m128i*)(src + i));
+        __m128i b = _mm_loadu_si128 ((const __m128i*)(src + i + 4));
+        _mm_storeu_si128 ((__m128i*)(dest + i), brighten4 (a, iffV));
+        _mm_storeu_si128 ((__m128i*)(dest + i + 4), brighten4 (b, iffV));
+    }
+
+    if (i < n)
+        create_output_with_uniform_brightness_c (src + i, dest + i, n - i, iff);
+}
+
+#endif /* HAVE_SSE2 */
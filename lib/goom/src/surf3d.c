@@ -13,6 +13,7 @@ grid3d *grid3d_new (int sizex, int defx, int sizez, int defz, v3d center) {
 	s->vertex = malloc (x*y*sizeof(v3d));
 	s->svertex = malloc (x*y*sizeof(v3d));
 	s->center = center;
+	g->projected = malloc (x*y*sizeof(v2d));
 
 	g->defx=defx;
 	g->sizex=sizex;
@@ -39,7 +40,7 @@ void grid3d_draw (PluginInfo *plug, grid3d *g, int color, int colorlow,
 	int x;
 	v2d v2,v2x;
 
-	v2d *v2_array = malloc(g->surf.nbvertex * sizeof(v2d));
+	v2d *v2_array = g->projected;
 	v3d_to_v2d(g->surf.svertex, g->surf.nbvertex, W, H, dist, v2_array);
 	
 	for (x=0;x<g->defx;x++) {
@@ -52,12 +53,12 @@ void grid3d_draw (PluginInfo *plug, grid3d *g, int color, int colorlow,
 					&& ((v2x.x != -666) || (v2x.y!=-666))) {
 				plug->methods.draw_line (buf,v2x.x,v2x.y,v2.x,v2.y, colorlow, W, H);
 				plug->methods.draw_line (back,v2x.x,v2x.y,v2.x,v2.y, color, W, H);
+				/* back is the displayed buffer */
+				plugin_info_overlay_line (plug,v2x.x,v2x.y,v2.x,v2.y);
 			}
 			v2x = v2;
 		}
 	}
-
-	free(v2_array);
 }
 
 void surf3d_rotate (surf3d *s, float angle) {
@@ -21,6 +21,8 @@ typedef struct {
 	int defz;
 	int sizez;
 	int mode;
+
+	v2d *projected; /* the vertex on the screen, for grid3d_draw */
 } grid3d;
 
 /* hi-level */
@@ -47,11 +47,11 @@ typedef struct _TENTACLE_FX_DATA {
 	int lock;
 } TentacleFXData;
 
-static void tentacle_new (TentacleFXData *data);
+static void tentacle_new (TentacleFXData *data, GoomRandom *gRandom);
 static void tentacle_update(PluginInfo *goomInfo, Pixel *buf, Pixel *back, int W, int H,
 gint16 data[NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN], float, int drawit, TentacleFXData *fx_data);
 static void tentacle_free (TentacleFXData *data);
-static void init_colors(uint32_t *colors);
+static void init_colors(uint32_t *colors, GoomRandom *gRandom);
 
 /* 
  * VisualFX wrapper for the tentacles
@@ -78,8 +78,8 @@ static void tentacle_fx_init(VisualFX *_this, PluginInfo *info) {
 	
 	data->rotation = 0;
 	data->lock = 0;
-	init_colors(data->colors);
-	tentacle_new(data);
+	init_colors(data->colors, info->gRandom);
+	tentacle_new(data, info->gRandom);
 
 	_this->params = &data->params;
 	_this->fx_data = (void*)data;
@@ -119,32 +119,33 @@ static void tentacle_free (TentacleFXData *data) {
 		grid3d *g = data->grille[tmp];
 		free (g->surf.vertex);
 		free (g->surf.svertex);
+		free (g->projected);
 		free (g);
 	}
 	free (data->vals);
 }
 
-static inline int get_rand_in_range(int n1, int n2)
+static inline int get_rand_in_range(GoomRandom *gRandom, int n1, int n2)
 {
 	const int range_len = n2 - n1 + 1;
-	return n1 + rand() % range_len;
+	return n1 + goom_irand(gRandom, range_len);
 }
 
-static void tentacle_new (TentacleFXData *data) {
+static void tentacle_new (TentacleFXData *data, GoomRandom *gRandom) {
 	v3d center = {0, 0, 0};
 	data->vals = (float*)malloc ((num_x+20)*sizeof(float));
 
 	/* Start at bottom of grid, going up by 'y_increment' */
 	float y = -0.5*(nbgrid * y_increment);
 	for (int tmp=0; tmp < nbgrid; tmp++) {
-		const int x = tentacle_offset_x + get_rand_in_range(-tentacle_mod_x/2, tentacle_mod_x/2);
-		const int z = tentacle_offset_z + get_rand_in_range(-tentacle_mod_z/2, tentacle_mod_z/2);
+		const int x = tentacle_offset_x + get_rand_in_range(gRandom, -tentacle_mod_x/2, tentacle_mod_x/2);
+		const int z = tentacle_offset_z + get_rand_in_range(gRandom, -tentacle_mod_z/2, tentacle_mod_z/2);
 
-		center.y = y + get_rand_in_range(-y_inc_mod/2, y_inc_mod/2);
+		center.y = y + get_rand_in_range(gRandom, -y_inc_mod/2, y_inc_mod/2);
 		center.z = z;
 		
-		data->grille[tmp] = grid3d_new (x, num_x + get_rand_in_range(-4, 4), 
-										z, num_z + get_rand_in_range(-6, 6), center);
+		data->grille[tmp] = grid3d_new (x, num_x + get_rand_in_range(gRandom, -4, 4), 
+										z, num_z + get_rand_in_range(gRandom, -6, 6), center);
 		
 		y += y_increment;
 	}
@@ -168,12 +169,12 @@ static inline unsigned char lighten (unsigned char value, float power)
 	}
 }
 
-static void init_colors(uint32_t *colors)
+static void init_colors(uint32_t *colors, GoomRandom *gRandom)
 {
 	for (int i=0; i < NB_TENTACLE_COLORS; i++) {
-		const uint8_t red = get_rand_in_range(20, 90);
-		const uint8_t green = get_rand_in_range(20, 90);
-		const uint8_t blue = get_rand_in_range(20, 90);
+		const uint8_t red = get_rand_in_range(gRandom, 20, 90);
+		const uint8_t green = get_rand_in_range(gRandom, 20, 90);
+		const uint8_t blue = get_rand_in_range(gRandom, 20, 90);
 		colors[i] = (red<<(ROUGE*8))|(green<<(VERT*8))|(blue<<(BLEU*8));
 	}
 }
@@ -307,7 +308,8 @@ static void tentacle_update(PluginInfo *goomInfo, Pixel *buf, Pixel *back, int W
 		pretty_move (goomInfo, fx_data->cycle, &dist, &dist2, &rotangle, fx_data);
 
 		for (int tmp=0;tmp<nbgrid;tmp++) {
-			for (int tmp2=0;tmp2<num_x;tmp2++) {
+			/* defx : num_x plus or minus 4 */
+			for (int tmp2=0;tmp2<fx_data->grille[tmp]->defx;tmp2++) {
 				const float val = (float)(ShiftRight(data[0][goom_irand(goomInfo->gRandom,AUDIO_SAMPLE_LEN-1)],10)) * rapport;
 				fx_data->vals[tmp2] = val;
 			}
@@ -0,0 +1,324 @@
+/*
+ *  thread_pool.c
+ *  Goom
+ *
+ *  Persistent worker threads used to run full frame passes by bands,
+ *  and background tasks.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "thread_pool.h"
+#include "cpu_info.h"
+
+#define MAX_THREADS 64
+
+#ifndef _WIN32PC
+
+#include <pthread.h>
+
+struct _GOOM_THREAD_POOL {
+    int nbThreads;
+    pthread_t *workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  start; /* signaled when a new job is available */
+    pthread_cond_t  done;  /* signaled when the last band of a job is done */
+
+    /* current job, protected by lock */
+    GoomBandFunc func;
+    void *arg;
+    int nbBands;
+    int nextBand;
+    int pendingBands;
+
+    int quit;
+};
+
+/* takes bands of the current job until there is no more.
+ * pool->lock is held on entry and on exit. */
+static void run_bands (GoomThreadPool *pool)
+{
+    while (pool->nextBand < pool->nbBands) {
+        int band = pool->nextBand++;
+        int nbBands = pool->nbBands;
+        GoomBandFunc func = pool->func;
+        void *arg = pool->arg;
+
+        pthread_mutex_unlock (&pool->lock);
+        func (arg, band, nbBands);
+        pthread_mutex_lock (&pool->lock);
+
+        if (--pool->pendingBands == 0)
+            pthread_cond_signal (&pool->done);
+    }
+}
+
+static void *worker_main (void *_pool)
+{
+    GoomThreadPool *pool = (GoomThreadPool*)_pool;
+
+    pthread_mutex_lock (&pool->lock);
+    while (1) {
+        while (!pool->quit && (pool->nextBand >= pool->nbBands))
+            pthread_cond_wait (&pool->start, &pool->lock);
+        if (pool->quit)
+            break;
+        run_bands (pool);
+    }
+    pthread_mutex_unlock (&pool->lock);
+    return NULL;
+}
+
+GoomThreadPool *goom_thread_pool_new (int nbThreads)
+{
+    GoomThreadPool *pool = (GoomThreadPool*)malloc (sizeof (GoomThreadPool));
+    int i;
+
+    if (nbThreads <= 0)
+        nbThreads = cpu_number ();
+    if (nbThreads > MAX_THREADS)
+        nbThreads = MAX_THREADS;
+
+    pool->func = NULL;
+    pool->arg = NULL;
+    pool->nbBands = pool->nextBand = pool->pendingBands = 0;
+    pool->quit = 0;
+
+    pthread_mutex_init (&pool->lock, NULL);
+    pthread_cond_init (&pool->start, NULL);
+    pthread_cond_init (&pool->done, NULL);
+
+    /* the calling thread is the first one of the pool */
+    pool->nbThreads = 1;
+    pool->workers = (pthread_t*)malloc (nbThreads * sizeof (pthread_t));
+    for (i = 1; i < nbThreads; ++i) {
+        if (pthread_create (&pool->workers[pool->nbThreads - 1], NULL, worker_main, pool) != 0)
+            break;
+        pool->nbThreads++;
+    }
+    return pool;
+}
+
+void goom_thread_pool_free (GoomThreadPool *pool)
+{
+    int i;
+
+    if (pool == NULL)
+        return;
+
+    pthread_mutex_lock (&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast (&pool->start);
+    pthread_mutex_unlock (&pool->lock);
+
+    for (i = 0; i < pool->nbThreads - 1; ++i)
+        pthread_join (pool->workers[i], NULL);
+
+    pthread_cond_destroy (&pool->done);
+    pthread_cond_destroy (&pool->start);
+    pthread_mutex_destroy (&pool->lock);
+    free (pool->workers);
+    free (pool);
+}
+
+void goom_thread_pool_run (GoomThreadPool *pool, int nbBands, GoomBandFunc func, void *arg)
+{
+    int band;
+
+    if ((pool == NULL) || (pool->nbThreads == 1) || (nbBands <= 1)) {
+        for (band = 0; band < nbBands; ++band)
+            func (arg, band, nbBands);
+        return;
+    }
+
+    pthread_mutex_lock (&pool->lock);
+    pool->func = func;
+    pool->arg = arg;
+    pool->nbBands = nbBands;
+    pool->nextBand = 0;
+    pool->pendingBands = nbBands;
+    pthread_cond_broadcast (&pool->start);
+
+    run_bands (pool);
+    while (pool->pendingBands > 0)
+        pthread_cond_wait (&pool->done, &pool->lock);
+
+    pool->nbBands = pool->nextBand = 0;
+    pthread_mutex_unlock (&pool->lock);
+}
+
+struct _GOOM_BACKGROUND_TASK {
+    GoomTaskFunc func;
+    void *arg;
+    int requestSize;
+    
+    void *pending; /* last posted request */
+    void *current; /* request given to func */
+    
+    int threaded;  /* 0 if the thread could not be started */
+    pthread_t thread;
+    
+    pthread_mutex_t lock;
+    pthread_cond_t  wake; /* signaled when a request is posted */
+    pthread_cond_t  idle; /* signaled when the last request is done */
+    
+    /* protected by lock */
+    int hasPending;
+    int running;
+    int quit;
+};
+
+static void *task_main (void *_task)
+{
+    GoomBackgroundTask *task = (GoomBackgroundTask*)_task;
+    
+    pthread_mutex_lock (&task->lock);
+    while (1) {
+        while (!task->quit && !task->hasPending)
+            pthread_cond_wait (&task->wake, &task->lock);
+        if (task->quit)
+            break;
+        
+        memcpy (task->current, task->pending, task->requestSize);
+        task->hasPending = 0;
+        task->running = 1;
+        
+        pthread_mutex_unlock (&task->lock);
+        task->func (task->arg, task->current);
+        pthread_mutex_lock (&task->lock);
+        
+        task->running = 0;
+        if (!task->hasPending)
+            pthread_cond_broadcast (&task->idle);
+    }
+    pthread_mutex_unlock (&task->lock);
+    return NULL;
+}
+
+GoomBackgroundTask *goom_background_task_new (GoomTaskFunc func, void *arg, int requestSize)
+{
+    GoomBackgroundTask *task = (GoomBackgroundTask*)malloc (sizeof (GoomBackgroundTask));
+    
+    task->func = func;
+    task->arg = arg;
+    task->requestSize = requestSize;
+    task->pending = malloc (requestSize);
+    task->current = malloc (requestSize);
+    task->hasPending = task->running = task->quit = 0;
+    
+    pthread_mutex_init (&task->lock, NULL);
+    pthread_cond_init (&task->wake, NULL);
+    pthread_cond_init (&task->idle, NULL);
+    
+    task->threaded = (pthread_create (&task->thread, NULL, task_main, task) == 0);
+    return task;
+}
+
+void goom_background_task_free (GoomBackgroundTask *task)
+{
+    if (task == NULL)
+        return;
+    
+    if (task->threaded) {
+        pthread_mutex_lock (&task->lock);
+        task->quit = 1;
+        pthread_cond_signal (&task->wake);
+        pthread_mutex_unlock (&task->lock);
+        pthread_join (task->thread, NULL);
+    }
+    
+    pthread_cond_destroy (&task->idle);
+    pthread_cond_destroy (&task->wake);
+    pthread_mutex_destroy (&task->lock);
+    free (task->pending);
+    free (task->current);
+    free (task);
+}
+
+void goom_background_task_post (GoomBackgroundTask *task, const void *request)
+{
+    if (!task->threaded) {
+        task->func (task->arg, request);
+        return;
+    }
+    
+    pthread_mutex_lock (&task->lock);
+    memcpy (task->pending, request, task->requestSize);
+    task->hasPending = 1;
+    pthread_cond_signal (&task->wake);
+    pthread_mutex_unlock (&task->lock);
+}
+
+void goom_background_task_wait (GoomBackgroundTask *task)
+{
+    if (!task->threaded)
+        return;
+    
+    pthread_mutex_lock (&task->lock);
+    while (task->hasPending || task->running)
+        pthread_cond_wait (&task->idle, &task->lock);
+    pthread_mutex_unlock (&task->lock);
+}
+
+#else /* _WIN32PC */
+
+/* no worker threads here: the bands are run in sequence by the caller */
+struct _GOOM_THREAD_POOL {
+    int nbThreads;
+};
+
+GoomThreadPool *goom_thread_pool_new (int nbThreads)
+{
+    GoomThreadPool *pool = (GoomThreadPool*)malloc (sizeof (GoomThreadPool));
+    pool->nbThreads = 1;
+    return pool;
+}
+
+void goom_thread_pool_free (GoomThreadPool *pool)
+{
+    free (pool);
+}
+
+void goom_thread_pool_run (GoomThreadPool *pool, int nbBands, GoomBandFunc func, void *arg)
+{
+    int band;
+    for (band = 0; band < nbBands; ++band)
+        func (arg, band, nbBands);
+}
+
+/* no thread either: the requests are run when they are posted */
+struct _GOOM_BACKGROUND_TASK {
+    GoomTaskFunc func;
+    void *arg;
+};
+
+GoomBackgroundTask *goom_background_task_new (GoomTaskFunc func, void *arg, int requestSize)
+{
+    GoomBackgroundTask *task = (GoomBackgroundTask*)malloc (sizeof (GoomBackgroundTask));
+    task->func = func;
+    task->arg = arg;
+    return task;
+}
+
+void goom_background_task_free (GoomBackgroundTask *task)
+{
+    free (task);
+}
+
+void goom_background_task_post (GoomBackgroundTask *task, const void *request)
+{
+    task->func (task->arg, request);
+}
+
+void goom_background_task_wait (GoomBackgroundTask *task)
+{
+}
+
+#endif /* _WIN32PC */
+
+int goom_thread_pool_size (GoomThreadPool *pool)
+{
+    return (pool == NULL) ? 1 : pool->nbThreads;
+}
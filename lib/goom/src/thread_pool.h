@@ -0,0 +1,49 @@
+#ifndef _GOOM_THREAD_POOL_H
+#define _GOOM_THREAD_POOL_H
+
+/**
+ * Persistent pool of worker threads.
+ *
+ * Full frame passes (the zoom filter...) are split into horizontal bands
+ * which are handed out to the workers. The calling thread works on the
+ * bands too, so a pool of 1 thread does not start any worker at all.
+ */
+
+typedef struct _GOOM_THREAD_POOL GoomThreadPool;
+
+/* called once for each band, band is in [0..nbBands-1] */
+typedef void (*GoomBandFunc) (void *arg, int band, int nbBands);
+
+/* nbThreads <= 0 : one thread per cpu (cf cpu_number) */
+GoomThreadPool *goom_thread_pool_new (int nbThreads);
+void goom_thread_pool_free (GoomThreadPool *pool);
+
+/* number of threads working on a job, including the calling one */
+int goom_thread_pool_size (GoomThreadPool *pool);
+
+/* runs func on all the bands and returns when they are all done.
+ * must not be called from two threads at the same time on the same pool. */
+void goom_thread_pool_run (GoomThreadPool *pool, int nbBands, GoomBandFunc func, void *arg);
+
+/**
+ * Background task.
+ *
+ * One worker thread running func each time a request is posted. Requests
+ * are copied, and when several are posted while func is running only the
+ * last one is run after it: the latest request wins.
+ */
+
+typedef struct _GOOM_BACKGROUND_TASK GoomBackgroundTask;
+
+typedef void (*GoomTaskFunc) (void *arg, const void *request);
+
+GoomBackgroundTask *goom_background_task_new (GoomTaskFunc func, void *arg, int requestSize);
+void goom_background_task_free (GoomBackgroundTask *task);
+
+/* never blocks on func. without threads (_WIN32PC...), func is run right now. */
+void goom_background_task_post (GoomBackgroundTask *task, const void *request);
+
+/* returns when no request is running or pending anymore */
+void goom_background_task_wait (GoomBackgroundTask *task);
+
+#endif
@@ -1,6 +1,8 @@
 
 #ifdef HAVE_MMX
 
+#include "goom_filters.h"
+
 /* a definir pour avoir exactement le meme resultat que la fonction C
  * (un chouillat plus lent).. mais la difference est assez peu notable.
  */
@@ -26,23 +28,21 @@ int xmmx_supported (void) {
 	return (mm_support()&0x8)>>3;
 }
 
-void zoom_filter_xmmx (int prevX, int prevY,
+void zoom_filter_xmmx (int prevX, int prevY, int start, int end,
                        Pixel *expix1, Pixel *expix2,
-                       int *lbruS, int *lbruD, int buffratio,
+                       const ZoomTransform *brutS, const ZoomTransform *brutD, int buffratio,
                        int precalCoef[16][16])
 {
-	int bufsize = prevX * prevY; /* taille du buffer */
+	int bufend = end; /* fin de la bande */
 	volatile int loop;                    /* variable de boucle */
 
-	mmx_t *brutS = (mmx_t*)lbruS; /* buffer de transformation source */
-	mmx_t *brutD = (mmx_t*)lbruD; /* buffer de transformation dest */
+	volatile mmx_t posS; /* [X|Y] de la source pour ce pixel */
+	volatile mmx_t posD; /* [X|Y] de la destination pour ce pixel */
 
 	volatile mmx_t prevXY;
 	volatile mmx_t ratiox;
 	/*	volatile mmx_t interpix; */
 
-	expix1[0].val=expix1[prevX-1].val=expix1[prevX*prevY-1].val=expix1[prevX*prevY-prevX].val=0;
-
 	prevXY.ud[0] = (prevX-1)<<PERTEDEC;
 	prevXY.ud[1] = (prevY-1)<<PERTEDEC;
 
@@ -55,12 +55,12 @@ void zoom_filter_xmmx (int prevX, int prevY,
      "\n\t pxor  %%mm7,    %%mm7" /* mm7 = 0 */
      ::[ratio]"m"(ratiox));
 
-	loop=0;
+	loop=start;
 
 	/*
 	 * NOTE : mm6 et mm7 ne sont pas modifies dans la boucle.
 	 */
-	while (loop < bufsize)
+	while (loop < bufend)
 	{
 		/* Thread #1
 		 * pre :  mm6 = [rat16|rat16]
@@ -68,8 +68,14 @@ void zoom_filter_xmmx (int prevX, int prevY,
 		 * modified = mm0,mm1,mm2
 		 */
 
-    asm volatile ("#1 \n\t movq 0(%[brutS]), %%mm0"
-       "#1 \n\t movq 0(%[brutD]), %%mm1"
+		/* les X et les Y sont dans des plans separes */
+		posS.d[0] = brutS->x[loop];
+		posS.d[1] = brutS->y[loop];
+		posD.d[0] = brutD->x[loop];
+		posD.d[1] = brutD->y[loop];
+
+    asm volatile ("#1 \n\t movq %[brutS], %%mm0"
+       "#1 \n\t movq %[brutD], %%mm1"
        "#1 \n\t psubd   %%mm0, %%mm1"  /* mm1 = D - S */
        "#1 \n\t movq    %%mm1, %%mm2" /* mm2 = D - S */
        "#1 \n\t pslld     $16, %%mm1"
@@ -81,7 +87,7 @@ void zoom_filter_xmmx (int prevX, int prevY,
        "#1 \n\t paddd   %%mm1, %%mm0"  /* mm0 = S + mm1 */
        "#1 \n\t psrld   $16,   %%mm0"
        :
-       :[brutS] "r" (&brutS[loop]) ,[brutD] "r" (&brutD[loop])
+       :[brutS] "m" (posS) ,[brutD] "m" (posD)
          );                      /* mm0 = S */
 
 		/*
@@ -0,0 +1,183 @@
+/*
+ * goom_bench : frame time of goom_update, and of each of its stages when
+ * goom is built with GOOM_PROFILE, on the sound of a file.
+ *
+ * usage : goom_bench [-s WIDTHxHEIGHT] [-n frames] [-t threads] [-o text|json|csv] [file]
+ *
+ * file : a WAV (16 bits PCM or 32 bits float, mono or stereo) or raw PCM
+ * (16 bits signed, little endian, stereo). It is read again from the start
+ * when it is too short. Without a file, a made up sound with regular beats.
+ *
+ * Each frame takes the next AUDIO_SAMPLE_LEN samples of each channel, the
+ * way Kodi gives them. The first frames (new zoom maps, cold caches) are
+ * run but not counted.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "goom.h"
+#include "sound_file.h"
+
+#define WARMUP_FRAMES 16
+
+static double now (void)
+{
+    struct timespec t;
+    timespec_get (&t, TIME_UTC);
+    return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+static int cmp_float (const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    double mean, p50, p99; /* ms */
+} Times;
+
+/* sorts times */
+static Times times_of (float *times, int n)
+{
+    Times t;
+    double sum = 0.0;
+    int i;
+
+    for (i = 0; i < n; ++i)
+        sum += times[i];
+    qsort (times, n, sizeof(float), cmp_float);
+    t.mean = sum / n;
+    t.p50 = times[(int)(0.50 * (n - 1) + 0.5)];
+    t.p99 = times[(int)(0.99 * (n - 1) + 0.5)];
+    return t;
+}
+
+static void usage (void)
+{
+    fprintf (stderr, "usage : goom_bench [-s WIDTHxHEIGHT] [-n frames] [-t threads] [-o text|json|csv] [file]\n");
+    exit (1);
+}
+
+int main (int argc, char **argv)
+{
+    int width = 1280, height = 720, frames = 1000, threads = 0;
+    const char *output = "text", *path = NULL;
+    gint16 data[NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN];
+    float *frameTimes, *stageTimes[GOOM_NB_STAGES];
+    Times frame, stage[GOOM_NB_STAGES];
+    int profiled = 1;
+    PluginInfo *goom;
+    Sound sound;
+    double total;
+    int i, s;
+
+    for (i = 1; i < argc; ++i) {
+        if (!strcmp (argv[i], "-s") && (i + 1 < argc)) {
+            if (sscanf (argv[++i], "%dx%d", &width, &height) != 2)
+                usage ();
+        }
+        else if (!strcmp (argv[i], "-n") && (i + 1 < argc))
+            frames = atoi (argv[++i]);
+        else if (!strcmp (argv[i], "-t") && (i + 1 < argc))
+            threads = atoi (argv[++i]);
+        else if (!strcmp (argv[i], "-o") && (i + 1 < argc))
+            output = argv[++i];
+        else if ((argv[i][0] != '-') && (path == NULL))
+            path = argv[i];
+        else
+            usage ();
+    }
+    if ((width < 16) || (height < 16) || (frames < 1)
+        || (strcmp (output, "text") && strcmp (output, "json") && strcmp (output, "csv")))
+        usage ();
+
+    if ((width > GOOM_MAX_SIZE) || (height > GOOM_MAX_SIZE)) {
+        fprintf (stderr, "goom is at most %dx%d\n", GOOM_MAX_SIZE, GOOM_MAX_SIZE);
+        return 1;
+    }
+    if (path == NULL)
+        sound_make (&sound);
+    else if (!sound_load (path, &sound))
+        return 1;
+
+    goom = goom_init (width, height);
+    goom_set_threads (goom, threads);
+
+    for (i = 0; i < WARMUP_FRAMES; ++i) {
+        sound_next_window (&sound, data);
+        goom_update (goom, data, 0, 0.0f, (i == 0) ? "goom_bench" : NULL, NULL);
+    }
+
+    frameTimes = (float *) malloc (frames * sizeof(float));
+    for (s = 0; s < GOOM_NB_STAGES; ++s)
+        stageTimes[s] = (float *) malloc (frames * sizeof(float));
+
+    total = now ();
+    for (i = 0; i < frames; ++i) {
+        GoomStageStats stats[GOOM_NB_STAGES];
+        double t;
+
+        sound_next_window (&sound, data);
+        t = now ();
+        goom_update (goom, data, 0, 0.0f, NULL, NULL);
+        frameTimes[i] = (float)((now () - t) * 1000.0);
+
+        if (goom_get_stage_stats (goom, stats) == 0)
+            profiled = 0;
+        for (s = 0; s < GOOM_NB_STAGES; ++s)
+            stageTimes[s][i] = stats[s].last / 1000.0f;
+    }
+    total = now () - total;
+
+    frame = times_of (frameTimes, frames);
+    for (s = 0; s < GOOM_NB_STAGES; ++s)
+        stage[s] = times_of (stageTimes[s], frames);
+
+    if (!strcmp (output, "json")) {
+        printf ("{\n  \"width\": %d, \"height\": %d, \"frames\": %d, \"threads\": %d,\n",
+                width, height, frames, threads);
+        printf ("  \"input\": \"%s\",\n", (path != NULL) ? path : "");
+        printf ("  \"fps\": %.2f,\n", frames / total);
+        printf ("  \"frame_ms\": {\"mean\": %.4f, \"p50\": %.4f, \"p99\": %.4f}", frame.mean, frame.p50, frame.p99);
+        if (profiled) {
+            printf (",\n  \"stages_ms\": {\n");
+            for (s = 0; s < GOOM_NB_STAGES; ++s)
+                printf ("    \"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p99\": %.4f}%s\n", goom_stage_name (s),
+                        stage[s].mean, stage[s].p50, stage[s].p99, (s + 1 < GOOM_NB_STAGES) ? "," : "");
+            printf ("  }");
+        }
+        printf ("\n}\n");
+    }
+    else if (!strcmp (output, "csv")) {
+        /* one line per stage, "goom_update" for the frame time seen from outside */
+        printf ("width,height,frames,threads,fps,stage,mean_ms,p50_ms,p99_ms\n");
+        printf ("%d,%d,%d,%d,%.2f,goom_update,%.4f,%.4f,%.4f\n",
+                width, height, frames, threads, frames / total, frame.mean, frame.p50, frame.p99);
+        for (s = 0; profiled && (s < GOOM_NB_STAGES); ++s)
+            printf ("%d,%d,%d,%d,%.2f,%s,%.4f,%.4f,%.4f\n", width, height, frames, threads, frames / total,
+                    goom_stage_name (s), stage[s].mean, stage[s].p50, stage[s].p99);
+    }
+    else {
+        printf ("%dx%d, %d frames, %s : %.1f fps\n", width, height, frames,
+                (path != NULL) ? path : "made up sound", frames / total);
+        printf ("%-12s %9s %9s %9s\n", "ms", "mean", "p50", "p99");
+        printf ("%-12s %9.3f %9.3f %9.3f\n", "goom_update", frame.mean, frame.p50, frame.p99);
+        if (profiled)
+            for (s = 0; s < GOOM_NB_STAGES; ++s)
+                printf ("%-12s %9.3f %9.3f %9.3f\n", goom_stage_name (s), stage[s].mean, stage[s].p50, stage[s].p99);
+        else
+            printf ("no time of the stages, goom is built without GOOM_PROFILE\n");
+    }
+
+    goom_close (goom);
+    for (s = 0; s < GOOM_NB_STAGES; ++s)
+        free (stageTimes[s]);
+    free (frameTimes);
+    sound_free (&sound);
+    return 0;
+}
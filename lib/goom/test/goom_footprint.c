@@ -0,0 +1,92 @@
+/*
+ * goom_footprint : goom_init at the biggest size, then going down and up
+ * allocates nothing (cf goom_set_resolution in goom.h).
+ *
+ * A goom starts at a smaller size, as the adaptive quality of the addon does,
+ * then walks the sizes of the addon up and down twice : goom_memory_footprint must
+ * not move, and must be the one of a goom that always stayed at its biggest size.
+ * The sizes beyond GOOM_MAX_SIZE are refused, by goom_init as by goom_set_resolution.
+ */
+
+#include <stdio.h>
+
+#include "goom.h"
+
+#define WIDTH 640
+#define HEIGHT 360
+#define FRAMES 24 /* at each size, the background maps and the cache have time to fill */
+
+/* the sizes of the addon : from a quarter to all, by eighths */
+#define MIN_EIGHTHS 2
+
+static void render (PluginInfo *goom, int frames, unsigned int *rnd)
+{
+    gint16 data[NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN];
+    int frame, i;
+
+    for (frame = 0; frame < frames; ++frame) {
+        for (i = 0; i < AUDIO_SAMPLE_LEN; ++i) {
+            *rnd = *rnd * 1664525u + 1013904223u;
+            data[0][i] = (gint16)((int)(*rnd >> 16) - 32768);
+            data[1][i] = (gint16)(data[0][i] / 2);
+        }
+        goom_update (goom, data, 0, 0.0f, NULL, NULL);
+    }
+}
+
+static void set_eighths (PluginInfo *goom, int eighths)
+{
+    goom_set_resolution (goom, (WIDTH * eighths / 8) & ~1, (HEIGHT * eighths / 8) & ~1);
+}
+
+int main (void)
+{
+    PluginInfo *goom;
+    unsigned int rnd = 1;
+    size_t biggest, first, footprint;
+    int failures = 0;
+    int pass, eighths;
+
+    goom = goom_init_seeded (WIDTH, HEIGHT, 1);
+    render (goom, FRAMES, &rnd);
+    biggest = goom_memory_footprint (goom);
+    goom_close (goom);
+    printf ("%dx%d : %zu bytes\n", WIDTH, HEIGHT, biggest);
+
+    goom = goom_init_seeded (WIDTH, HEIGHT, 1);
+    set_eighths (goom, 5);
+    render (goom, FRAMES, &rnd);
+    first = goom_memory_footprint (goom);
+    if (first != biggest) {
+        printf ("started at 5/8 : %zu bytes, not the ones of %dx%d\n", first, WIDTH, HEIGHT);
+        failures++;
+    }
+
+    for (pass = 0; pass < 2; ++pass) {
+        for (eighths = 6; eighths <= 8; ++eighths) {
+            set_eighths (goom, eighths);
+            render (goom, FRAMES, &rnd);
+        }
+        for (eighths = 7; eighths >= MIN_EIGHTHS; --eighths) {
+            set_eighths (goom, eighths);
+            render (goom, FRAMES, &rnd);
+        }
+        footprint = goom_memory_footprint (goom);
+        printf ("up and down %d : %zu bytes\n", pass + 1, footprint);
+        if (footprint != first) {
+            printf ("the footprint moved : %lld bytes\n", (long long) footprint - (long long) first);
+            failures++;
+        }
+    }
+
+    if (goom_set_resolution (goom, 2560, 1440) || (goom->screen.width != 2 * WIDTH / 8)) {
+        printf ("2560x1440 not refused by goom_set_resolution\n");
+        failures++;
+    }
+    goom_close (goom);
+    if (goom_init (3840, 2160) != NULL) {
+        printf ("3840x2160 not refused by goom_init\n");
+        failures++;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,308 @@
+/*
+ * goom_golden : goom_init_seeded must give the same frames, bit for bit, with
+ * every SIMD method and number of threads as with the C methods on one thread,
+ * and those must be the golden ones.
+ *
+ * usage : goom_golden goldens_file        checks
+ *         goom_golden -update goldens_file  writes the golden hashes again
+ *
+ * The Fused Output of the convolve FX (made by the bands of the zoom, then the
+ * pixels drawn after the zoom made again) must give the frames of the full output,
+ * with 1 and 4 threads.
+ *
+ * Then gooms of the sizes render all at once, on threads of their own : they
+ * must give the frames they give one by one, and so must goom_update_batch.
+ *
+ * The hashes are those of the C methods : a change of the pictures of goom
+ * on purpose needs -update, anything else is a bug. Another compiler or libm
+ * may round the floats of goom differently, the goldens are then to be made
+ * again there, the methods are still checked against the C ones.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32PC
+#include <pthread.h>
+#endif
+
+#include "cpu_info.h"
+#include "goom.h"
+#include "goom_plugin_info.h"
+
+#define SEED 20041121
+#define FRAMES 240
+#define HASH_EVERY 20
+#define NB_HASHES (FRAMES / HASH_EVERY)
+
+static const int sizes[][2] = { { 320, 180 }, { 250, 150 } };
+#define NB_SIZES (int)(sizeof(sizes) / sizeof(sizes[0]))
+
+static const struct {
+    const char *name;
+    unsigned int cpuFlavour;
+} flavours[] = {
+    { "c", 0 },
+    { "sse2", CPU_OPTION_SSE | CPU_OPTION_SSE2 },
+    { "avx2", CPU_OPTION_SSE | CPU_OPTION_SSE2 | CPU_OPTION_AVX2 },
+    { "neon", CPU_OPTION_NEON },
+};
+#define NB_FLAVOURS (int)(sizeof(flavours) / sizeof(flavours[0]))
+
+static const int threads[] = { 1, 4 };
+#define NB_THREADS (int)(sizeof(threads) / sizeof(threads[0]))
+
+/* frames of goom_update_batch, the title of frame 10 at the start of one */
+#define BATCH 5
+
+/* integers only, the same everywhere : a noise and a square wave, with a beat every second */
+static void make_window (int frame, gint16 data[NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN], unsigned int *rnd)
+{
+    int beat = ((frame % 86) < 8) ? 4 : 1;
+    int i;
+
+    for (i = 0; i < AUDIO_SAMPLE_LEN; ++i) {
+        int square = ((i / (16 + (frame / 50) % 4 * 8)) & 1) ? 3000 : -3000;
+        int noise;
+        *rnd = *rnd * 1664525u + 1013904223u;
+        noise = (int)(*rnd >> 20) - 2048;
+        data[0][i] = (gint16)(square + noise * beat * 2);
+        data[1][i] = (gint16)(square * beat / 2 - noise);
+    }
+}
+
+/* fnv-1a */
+static unsigned long long hash_frame (const guint32 *pixels, int size)
+{
+    unsigned long long h = 14695981039346656037ULL;
+    int i;
+    for (i = 0; i < size; ++i) {
+        h = (h ^ pixels[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+static void run_batch (PluginInfo *goom, int size, int batch, unsigned long long hashes[NB_HASHES])
+{
+    gint16 (*data)[NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN] = malloc (batch * sizeof(*data));
+    guint32 **frames = malloc (batch * sizeof(*frames));
+    unsigned int rnd = 1;
+    int frame, i;
+
+    for (i = 0; i < batch; ++i)
+        frames[i] = goom_alloc_screenbuffer (goom);
+    for (frame = 0; frame < FRAMES; frame += batch) {
+        for (i = 0; i < batch; ++i)
+            make_window (frame + i, data[i], &rnd);
+        goom_update_batch (goom, (const gint16 (*)[NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN]) data, frames, batch,
+                           0, 0.0f, (frame == 10) ? "goom golden" : NULL, NULL);
+        for (i = 0; i < batch; ++i) {
+            if ((frame + i + 1) % HASH_EVERY == 0)
+                hashes[(frame + i) / HASH_EVERY] = hash_frame (frames[i], size);
+        }
+    }
+    for (i = 0; i < batch; ++i)
+        goom_free_screenbuffer (frames[i]);
+    free (frames);
+    free (data);
+}
+
+/* the output of the frame made by the bands of the zoom, cf goom_update */
+static void set_fused (PluginInfo *goom)
+{
+    PluginParameters *params = goom->convolve_fx.params;
+    int i;
+    for (i = 0; i < params->nbParams; ++i) {
+        if ((params->params[i] != NULL) && !strcmp (params->params[i]->name, "Fused Output"))
+            BVAL(*params->params[i]) = 1;
+    }
+}
+
+/* batch : 0 for goom_update, or frames of goom_update_batch */
+static void run (int width, int height, unsigned int cpuFlavour, int nbThreads, int batch, int fused,
+                 unsigned long long hashes[NB_HASHES])
+{
+    PluginInfo *goom = goom_init_seeded (width, height, SEED);
+    gint16 data[NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN];
+    unsigned int rnd = 1;
+    int frame;
+
+    plugin_info_set_cpu_flavour (goom, cpuFlavour);
+    goom_set_threads (goom, nbThreads);
+    if (fused)
+        set_fused (goom);
+    if (batch > 0) {
+        run_batch (goom, width * height, batch, hashes);
+        goom_close (goom);
+        return;
+    }
+    for (frame = 0; frame < FRAMES; ++frame) {
+        guint32 *pixels;
+        make_window (frame, data, &rnd);
+        pixels = goom_update (goom, data, 0, 0.0f, (frame == 10) ? "goom golden" : NULL, NULL);
+        if ((frame + 1) % HASH_EVERY == 0)
+            hashes[frame / HASH_EVERY] = hash_frame (pixels, width * height);
+    }
+    goom_close (goom);
+}
+
+#ifndef _WIN32PC
+/* gooms at the same time, twice each size */
+#define NB_CONCURRENT (2 * NB_SIZES)
+
+typedef struct {
+    pthread_t thread;
+    int size;
+    unsigned long long hashes[NB_HASHES];
+} Concurrent;
+
+static void *run_concurrent (void *arg)
+{
+    Concurrent *c = (Concurrent *) arg;
+    run (sizes[c->size][0], sizes[c->size][1], 0, 1, 0, 0, c->hashes);
+    return NULL;
+}
+
+static int check_concurrent (unsigned long long reference[NB_SIZES][NB_HASHES])
+{
+    Concurrent c[NB_CONCURRENT];
+    int failures = 0;
+    int n;
+
+    for (n = 0; n < NB_CONCURRENT; ++n) {
+        c[n].size = n % NB_SIZES;
+        pthread_create (&c[n].thread, NULL, run_concurrent, &c[n]);
+    }
+    for (n = 0; n < NB_CONCURRENT; ++n) {
+        pthread_join (c[n].thread, NULL);
+        if (memcmp (c[n].hashes, reference[c[n].size], sizeof(c[n].hashes))) {
+            printf ("%dx%d, %d gooms at once : not the frames of one goom\n",
+                    sizes[c[n].size][0], sizes[c[n].size][1], NB_CONCURRENT);
+            failures++;
+        }
+    }
+    if (failures == 0)
+        printf ("%d gooms at once : same\n", NB_CONCURRENT);
+    return failures;
+}
+#endif
+
+int main (int argc, char **argv)
+{
+    unsigned long long golden[NB_SIZES][NB_HASHES];
+    unsigned long long reference[NB_SIZES][NB_HASHES];
+    int update = (argc == 3) && !strcmp (argv[1], "-update");
+    const char *path = argv[argc - 1];
+    int failures = 0;
+    int s, f, t, i;
+    FILE *file;
+
+    if ((argc != 2) && !update) {
+        fprintf (stderr, "usage : goom_golden [-update] goldens_file\n");
+        return 2;
+    }
+
+    if (!update) {
+        file = fopen (path, "r");
+        if (file == NULL) {
+            perror (path);
+            return 2;
+        }
+        for (s = 0; s < NB_SIZES; ++s) {
+            for (i = 0; i < NB_HASHES; ++i) {
+                if (fscanf (file, "%llx", &golden[s][i]) != 1) {
+                    fprintf (stderr, "%s : not enough hashes\n", path);
+                    return 2;
+                }
+            }
+        }
+        fclose (file);
+    }
+
+    for (s = 0; s < NB_SIZES; ++s) {
+        const int width = sizes[s][0], height = sizes[s][1];
+
+        run (width, height, 0, 1, 0, 0, reference[s]);
+        if (update) {
+            memcpy (golden[s], reference[s], sizeof(reference[s]));
+        }
+        else {
+            for (i = 0; i < NB_HASHES; ++i) {
+                if (reference[s][i] != golden[s][i]) {
+                    printf ("%dx%d c, 1 thread : frame %d is not the golden one\n", width, height, (i + 1) * HASH_EVERY);
+                    failures++;
+                    break;
+                }
+            }
+        }
+
+        for (f = 0; f < NB_FLAVOURS; ++f) {
+            /* the methods of this cpu only, once each */
+            unsigned int cpuFlavour = flavours[f].cpuFlavour & cpu_flavour ();
+            if ((f > 0) && (cpuFlavour == 0))
+                continue;
+            for (t = 0; t < NB_THREADS; ++t) {
+                unsigned long long hashes[NB_HASHES];
+                if ((f == 0) && (t == 0))
+                    continue;
+                run (width, height, cpuFlavour, threads[t], 0, 0, hashes);
+                for (i = 0; i < NB_HASHES; ++i) {
+                    if (hashes[i] != reference[s][i]) {
+                        printf ("%dx%d %s, %d threads : frame %d differs from the C one\n", width, height,
+                                flavours[f].name, threads[t], (i + 1) * HASH_EVERY);
+                        failures++;
+                        break;
+                    }
+                }
+                if (i == NB_HASHES)
+                    printf ("%dx%d %s, %d threads : same\n", width, height, flavours[f].name, threads[t]);
+            }
+        }
+
+        {
+            unsigned long long hashes[NB_HASHES];
+            run (width, height, 0, 1, BATCH, 0, hashes);
+            if (memcmp (hashes, reference[s], sizeof(hashes))) {
+                printf ("%dx%d, goom_update_batch of %d : not the frames of goom_update\n", width, height, BATCH);
+                failures++;
+            }
+            else
+                printf ("%dx%d, goom_update_batch of %d : same\n", width, height, BATCH);
+        }
+
+        for (t = 0; t < NB_THREADS; ++t) {
+            unsigned long long hashes[NB_HASHES];
+            run (width, height, 0, threads[t], 0, 1, hashes);
+            for (i = 0; i < NB_HASHES; ++i) {
+                if (hashes[i] != reference[s][i]) {
+                    printf ("%dx%d fused output, %d threads : frame %d differs from the full output\n",
+                            width, height, threads[t], (i + 1) * HASH_EVERY);
+                    failures++;
+                    break;
+                }
+            }
+            if (i == NB_HASHES)
+                printf ("%dx%d fused output, %d threads : same\n", width, height, threads[t]);
+        }
+    }
+
+#ifndef _WIN32PC
+    failures += check_concurrent (reference);
+#endif
+
+    if (update) {
+        file = fopen (path, "w");
+        if (file == NULL) {
+            perror (path);
+            return 2;
+        }
+        for (s = 0; s < NB_SIZES; ++s) {
+            for (i = 0; i < NB_HASHES; ++i)
+                fprintf (file, "%016llx%c", golden[s][i], (i + 1 < NB_HASHES) ? ' ' : '\n');
+        }
+        fclose (file);
+        printf ("goldens written to %s\n", path);
+    }
+    return failures ? 1 : 0;
+}
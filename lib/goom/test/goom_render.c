@@ -0,0 +1,388 @@
+/*
+ * goom_render : the frames of goom for sound files, as fast as the cpu goes,
+ * in a Y4M stream (for an encoder : ffmpeg -i out.y4m ...) or raw RGBA.
+ *
+ * usage : goom_render [-s WIDTHxHEIGHT] [-r fps] [-f y4m|rgba] [-j files at once]
+ *                     [-t threads of a goom] [-S seed] [-T] [-o out] files...
+ *
+ * files : cf sound_file.h. The stream of a file goes next to it (the extension
+ * becomes .y4m or .rgba), or to out with a single file, - being stdout.
+ *
+ * The files are rendered by -j workers (as many as cpus by default), each with
+ * its goom. A worker converts a frame while its writer thread writes the one
+ * before : the disk is not waited for, but when it is slower than goom.
+ *
+ * Frame n shows the AUDIO_SAMPLE_LEN samples from n / fps on, the frames go
+ * on until the end of the sound, BATCH at a time (goom_update_batch). -S seed gives the same frames at each run
+ * (goom_init_seeded). -T shows the name of the file at the start, as Kodi
+ * does with the title of a song.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cpu_info.h"
+#include "goom.h"
+#include "goom_graphic.h"
+#include "sound_file.h"
+
+/* frames of a goom_update_batch */
+#define BATCH 8
+
+typedef struct {
+    int width, height, fps;
+    int y4m;
+    int threads;
+    int seeded;
+    guint32 seed;
+    int showName;
+} Options;
+
+/* a frame converted, waiting for the writer */
+typedef struct {
+    unsigned char *bytes;
+    int full;
+} Slot;
+
+/* writes the frames a worker gives it, in their order */
+typedef struct {
+    FILE *file;
+    size_t frameSize;
+    Slot slots[2];
+    int toFill, toWrite; /* slots of the worker, of the writer thread */
+    int finished, failed;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    pthread_t thread;
+} Writer;
+
+typedef struct {
+    const Options *options;
+    char **files;
+    const char *out; /* of the single file, NULL : next to it */
+    int nbFiles;
+    int next;        /* file for the next free worker */
+    int failures;
+    pthread_mutex_t lock;
+} Jobs;
+
+static double now (void)
+{
+    struct timespec t;
+    timespec_get (&t, TIME_UTC);
+    return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+static void *write_frames (void *arg)
+{
+    Writer *w = (Writer *) arg;
+
+    pthread_mutex_lock (&w->lock);
+    for (;;) {
+        Slot *slot = &w->slots[w->toWrite];
+        if (slot->full) {
+            int ok;
+            pthread_mutex_unlock (&w->lock);
+            ok = (fwrite (slot->bytes, 1, w->frameSize, w->file) == w->frameSize);
+            pthread_mutex_lock (&w->lock);
+            if (!ok)
+                w->failed = 1;
+            slot->full = 0;
+            w->toWrite ^= 1;
+            pthread_cond_signal (&w->changed);
+        }
+        else if (w->finished)
+            break;
+        else
+            pthread_cond_wait (&w->changed, &w->lock);
+    }
+    pthread_mutex_unlock (&w->lock);
+    return NULL;
+}
+
+static void writer_start (Writer *w, FILE *file, size_t frameSize)
+{
+    int i;
+
+    w->file = file;
+    w->frameSize = frameSize;
+    for (i = 0; i < 2; ++i) {
+        w->slots[i].bytes = (unsigned char *) malloc (frameSize);
+        w->slots[i].full = 0;
+    }
+    w->toFill = w->toWrite = 0;
+    w->finished = w->failed = 0;
+    pthread_mutex_init (&w->lock, NULL);
+    pthread_cond_init (&w->changed, NULL);
+    pthread_create (&w->thread, NULL, write_frames, w);
+}
+
+/* the slot to convert the next frame in, once the writer is done with it */
+static unsigned char *writer_slot (Writer *w)
+{
+    Slot *slot = &w->slots[w->toFill];
+
+    pthread_mutex_lock (&w->lock);
+    while (slot->full)
+        pthread_cond_wait (&w->changed, &w->lock);
+    pthread_mutex_unlock (&w->lock);
+    return slot->bytes;
+}
+
+static void writer_push (Writer *w)
+{
+    pthread_mutex_lock (&w->lock);
+    w->slots[w->toFill].full = 1;
+    w->toFill ^= 1;
+    pthread_cond_signal (&w->changed);
+    pthread_mutex_unlock (&w->lock);
+}
+
+/* 0 if a frame could not be written */
+static int writer_finish (Writer *w)
+{
+    int i;
+
+    pthread_mutex_lock (&w->lock);
+    w->finished = 1;
+    pthread_cond_signal (&w->changed);
+    pthread_mutex_unlock (&w->lock);
+    pthread_join (w->thread, NULL);
+
+    pthread_cond_destroy (&w->changed);
+    pthread_mutex_destroy (&w->lock);
+    for (i = 0; i < 2; ++i)
+        free (w->slots[i].bytes);
+    return !w->failed;
+}
+
+/* "FRAME" then the planes 4:2:0, BT.601 limited range, chroma of 2x2 pixels */
+static void to_y4m (const Pixel *pix, int width, int height, unsigned char *out)
+{
+    const int cw = (width + 1) / 2, ch = (height + 1) / 2;
+    unsigned char *y = out + 6, *u = y + width * height, *v = u + cw * ch;
+    int i, j;
+
+    memcpy (out, "FRAME\n", 6);
+    for (i = 0; i < width * height; ++i) {
+        const int r = pix[i].channels.r, g = pix[i].channels.g, b = pix[i].channels.b;
+        y[i] = (unsigned char) (((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+    }
+    for (j = 0; j < ch; ++j) {
+        const int y0 = 2 * j, y1 = (2 * j + 1 < height) ? 2 * j + 1 : 2 * j;
+        for (i = 0; i < cw; ++i) {
+            const int x0 = 2 * i, x1 = (2 * i + 1 < width) ? 2 * i + 1 : 2 * i;
+            const Pixel *p00 = &pix[y0 * width + x0], *p01 = &pix[y0 * width + x1];
+            const Pixel *p10 = &pix[y1 * width + x0], *p11 = &pix[y1 * width + x1];
+            const int r = (p00->channels.r + p01->channels.r + p10->channels.r + p11->channels.r + 2) >> 2;
+            const int g = (p00->channels.g + p01->channels.g + p10->channels.g + p11->channels.g + 2) >> 2;
+            const int b = (p00->channels.b + p01->channels.b + p10->channels.b + p11->channels.b + 2) >> 2;
+            u[j * cw + i] = (unsigned char) (((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            v[j * cw + i] = (unsigned char) (((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+static void to_rgba (const Pixel *pix, int size, unsigned char *out)
+{
+    int i;
+    for (i = 0; i < size; ++i) {
+        out[4 * i] = pix[i].channels.r;
+        out[4 * i + 1] = pix[i].channels.g;
+        out[4 * i + 2] = pix[i].channels.b;
+        out[4 * i + 3] = 0xff;
+    }
+}
+
+/* out : "-" for stdout */
+static int render_file (const Options *o, const char *path, const char *out)
+{
+    const int width = o->width, height = o->height;
+    const size_t frameSize = o->y4m ? 6 + (size_t) width * height + 2 * (size_t) ((width + 1) / 2) * ((height + 1) / 2)
+                                     : 4 * (size_t) width * height;
+    const int toStdout = !strcmp (out, "-");
+    const char *name = strrchr (path, '/') ? strrchr (path, '/') + 1 : path;
+    gint16 data[BATCH][NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN];
+    guint32 *frames[BATCH];
+    PluginInfo *goom;
+    Writer writer;
+    Sound sound;
+    FILE *file;
+    long nbFrames, n;
+    double t;
+    int ok, i;
+
+    if (!sound_load (path, &sound))
+        return 0;
+    file = toStdout ? stdout : fopen (out, "wb");
+    if (file == NULL) {
+        perror (out);
+        sound_free (&sound);
+        return 0;
+    }
+    if (o->y4m)
+        fprintf (file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, o->fps);
+
+    goom = o->seeded ? goom_init_seeded (width, height, o->seed) : goom_init (width, height);
+    goom_set_threads (goom, o->threads);
+    for (i = 0; i < BATCH; ++i)
+        frames[i] = goom_alloc_screenbuffer (goom);
+    writer_start (&writer, file, frameSize);
+
+    /* up to the end of the sound, the last window ends with zeros */
+    nbFrames = (long) ((sound.nbFrames * (long long) o->fps + sound.rate - 1) / sound.rate);
+    t = now ();
+    for (n = 0; n < nbFrames; n += BATCH) {
+        const int nb = (nbFrames - n < BATCH) ? (int) (nbFrames - n) : BATCH;
+
+        for (i = 0; i < nb; ++i)
+            sound_window_at (&sound, (long) ((n + i) * (long long) sound.rate / o->fps), data[i]);
+        goom_update_batch (goom, (const gint16 (*)[NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN]) data, frames, nb,
+                           0, 0.0f, (o->showName && (n == 0)) ? name : NULL, NULL);
+
+        for (i = 0; i < nb; ++i) {
+            unsigned char *bytes = writer_slot (&writer);
+            if (o->y4m)
+                to_y4m ((const Pixel *) frames[i], width, height, bytes);
+            else
+                to_rgba ((const Pixel *) frames[i], width * height, bytes);
+            writer_push (&writer);
+        }
+    }
+    ok = writer_finish (&writer);
+    t = now () - t;
+    for (i = 0; i < BATCH; ++i)
+        goom_free_screenbuffer (frames[i]);
+    goom_close (goom);
+    sound_free (&sound);
+
+    if (toStdout)
+        ok = (fflush (file) == 0) && ok;
+    else
+        ok = (fclose (file) == 0) && ok;
+    if (!ok)
+        fprintf (stderr, "%s : could not be written\n", out);
+    else
+        fprintf (stderr, "%s : %ld frames, %.1f fps\n", out, nbFrames, (t > 0.0) ? nbFrames / t : 0.0);
+    return ok;
+}
+
+/* the name of the file with the extension of the stream */
+static char *out_of (const char *path, const char *extension)
+{
+    const char *slash = strrchr (path, '/');
+    const char *dot = strrchr (path, '.');
+    size_t len = ((dot != NULL) && ((slash == NULL) || (dot > slash))) ? (size_t) (dot - path) : strlen (path);
+    char *out = (char *) malloc (len + strlen (extension) + 1);
+
+    memcpy (out, path, len);
+    strcpy (out + len, extension);
+    return out;
+}
+
+static void *worker (void *arg)
+{
+    Jobs *jobs = (Jobs *) arg;
+
+    for (;;) {
+        int f, ok;
+        char *out;
+
+        pthread_mutex_lock (&jobs->lock);
+        f = jobs->next++;
+        pthread_mutex_unlock (&jobs->lock);
+        if (f >= jobs->nbFiles)
+            break;
+
+        out = (jobs->out != NULL) ? strdup (jobs->out)
+                                  : out_of (jobs->files[f], jobs->options->y4m ? ".y4m" : ".rgba");
+        ok = render_file (jobs->options, jobs->files[f], out);
+        free (out);
+        if (!ok) {
+            pthread_mutex_lock (&jobs->lock);
+            jobs->failures++;
+            pthread_mutex_unlock (&jobs->lock);
+        }
+    }
+    return NULL;
+}
+
+static void usage (void)
+{
+    fprintf (stderr, "usage : goom_render [-s WIDTHxHEIGHT] [-r fps] [-f y4m|rgba] [-j files at once]\n"
+                     "                    [-t threads of a goom] [-S seed] [-T] [-o out] files...\n");
+    exit (1);
+}
+
+int main (int argc, char **argv)
+{
+    Options options = { 1280, 720, 30, 1, 1, 0, 0, 0 };
+    const char *format = "y4m";
+    int nbWorkers = 0;
+    pthread_t *workers;
+    Jobs jobs;
+    int i;
+
+    memset (&jobs, 0, sizeof(jobs));
+    for (i = 1; i < argc; ++i) {
+        if (!strcmp (argv[i], "-s") && (i + 1 < argc)) {
+            if (sscanf (argv[++i], "%dx%d", &options.width, &options.height) != 2)
+                usage ();
+        }
+        else if (!strcmp (argv[i], "-r") && (i + 1 < argc))
+            options.fps = atoi (argv[++i]);
+        else if (!strcmp (argv[i], "-f") && (i + 1 < argc))
+            format = argv[++i];
+        else if (!strcmp (argv[i], "-j") && (i + 1 < argc))
+            nbWorkers = atoi (argv[++i]);
+        else if (!strcmp (argv[i], "-t") && (i + 1 < argc))
+            options.threads = atoi (argv[++i]);
+        else if (!strcmp (argv[i], "-S") && (i + 1 < argc)) {
+            options.seeded = 1;
+            options.seed = (guint32) strtoul (argv[++i], NULL, 0);
+        }
+        else if (!strcmp (argv[i], "-T"))
+            options.showName = 1;
+        else if (!strcmp (argv[i], "-o") && (i + 1 < argc))
+            jobs.out = argv[++i];
+        else if ((argv[i][0] != '-') || (argv[i][1] == '\0'))
+            break;
+        else
+            usage ();
+    }
+    jobs.files = argv + i;
+    jobs.nbFiles = argc - i;
+    options.y4m = !strcmp (format, "y4m");
+
+    if ((options.width < 16) || (options.height < 16) || (options.fps < 1) || (options.threads < 0)
+        || (jobs.nbFiles < 1) || (strcmp (format, "y4m") && strcmp (format, "rgba")))
+        usage ();
+    if ((options.width > GOOM_MAX_SIZE) || (options.height > GOOM_MAX_SIZE)) {
+        fprintf (stderr, "goom is at most %dx%d\n", GOOM_MAX_SIZE, GOOM_MAX_SIZE);
+        return 1;
+    }
+    if ((jobs.out != NULL) && (jobs.nbFiles > 1)) {
+        fprintf (stderr, "-o is for a single file, the others go next to theirs\n");
+        return 1;
+    }
+
+    if (nbWorkers <= 0)
+        nbWorkers = (int) cpu_number ();
+    if (nbWorkers > jobs.nbFiles)
+        nbWorkers = jobs.nbFiles;
+
+    jobs.options = &options;
+    pthread_mutex_init (&jobs.lock, NULL);
+    workers = (pthread_t *) malloc (nbWorkers * sizeof(pthread_t));
+    for (i = 0; i < nbWorkers; ++i)
+        pthread_create (&workers[i], NULL, worker, &jobs);
+    for (i = 0; i < nbWorkers; ++i)
+        pthread_join (workers[i], NULL);
+    pthread_mutex_destroy (&jobs.lock);
+    free (workers);
+
+    return jobs.failures ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+/*
+ *  sound_file.c
+ *  Goom
+ *
+ *  The sound of the test programs, from a file or made up.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sound_file.h"
+
+static unsigned int read_le (const unsigned char *p, int n)
+{
+    unsigned int v = 0;
+    while (n--)
+        v = (v << 8) | p[n];
+    return v;
+}
+
+static gint16 clip16 (float v)
+{
+    if (v > 32767.0f) return 32767;
+    if (v < -32768.0f) return -32768;
+    return (gint16)v;
+}
+
+/* 0 if the file is not a WAV, -1 if it is one that cannot be read */
+static int decode_wav (const unsigned char *buf, long size, Sound *sound)
+{
+    const unsigned char *fmt = NULL, *data = NULL;
+    long dataSize = 0, pos = 12, i;
+    int format, channels, bits;
+
+    if ((size < 12) || memcmp (buf, "RIFF", 4) || memcmp (buf + 8, "WAVE", 4))
+        return 0;
+    while (pos + 8 <= size) {
+        long chunkSize = read_le (buf + pos + 4, 4);
+        if (chunkSize > size - pos - 8)
+            chunkSize = size - pos - 8;
+        if (!memcmp (buf + pos, "fmt ", 4) && (chunkSize >= 16))
+            fmt = buf + pos + 8;
+        else if (!memcmp (buf + pos, "data", 4)) {
+            data = buf + pos + 8;
+            dataSize = chunkSize;
+        }
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+    if ((fmt == NULL) || (data == NULL))
+        return 0;
+
+    format = read_le (fmt, 2);
+    channels = read_le (fmt + 2, 2);
+    sound->rate = read_le (fmt + 4, 4);
+    bits = read_le (fmt + 14, 2);
+    if (format == 0xfffe) /* WAVE_FORMAT_EXTENSIBLE : the format is the start of the sub format */
+        format = read_le (fmt + 24, 2);
+    if (((channels != 1) && (channels != 2))
+        || !(((format == 1) && (bits == 16)) || ((format == 3) && (bits == 32))))
+        return -1;
+
+    sound->nbFrames = dataSize / (channels * bits / 8);
+    sound->samples = (gint16 *) malloc (sound->nbFrames * 2 * sizeof(gint16));
+    for (i = 0; i < sound->nbFrames * 2; ++i) {
+        long s = (channels == 2) ? i : i / 2;
+        if (format == 1)
+            sound->samples[i] = (gint16)read_le (data + s * 2, 2);
+        else {
+            unsigned int bitsOfFloat = read_le (data + s * 4, 4);
+            float f;
+            memcpy (&f, &bitsOfFloat, sizeof(f));
+            sound->samples[i] = clip16 (f * 32767.0f);
+        }
+    }
+    return 1;
+}
+
+int sound_load (const char *path, Sound *sound)
+{
+    FILE *f = fopen (path, "rb");
+    unsigned char *buf;
+    long size, i;
+    int wav;
+
+    memset (sound, 0, sizeof(Sound));
+    if (f == NULL) {
+        perror (path);
+        return 0;
+    }
+    fseek (f, 0, SEEK_END);
+    size = ftell (f);
+    fseek (f, 0, SEEK_SET);
+    buf = (unsigned char *) malloc (size > 0 ? size : 1);
+    if (fread (buf, 1, size, f) != (size_t)size) {
+        perror (path);
+        fclose (f);
+        free (buf);
+        return 0;
+    }
+    fclose (f);
+
+    wav = decode_wav (buf, size, sound);
+    if (wav < 0) {
+        fprintf (stderr, "%s : only 16 bits PCM or 32 bits float WAV, in mono or stereo\n", path);
+        free (buf);
+        return 0;
+    }
+    if (wav == 0) {
+        /* raw : 16 bits stereo */
+        sound->rate = 44100;
+        sound->nbFrames = size / 4;
+        sound->samples = (gint16 *) malloc (sound->nbFrames * 2 * sizeof(gint16));
+        for (i = 0; i < sound->nbFrames * 2; ++i)
+            sound->samples[i] = (gint16)read_le (buf + i * 2, 2);
+    }
+    free (buf);
+    if ((sound->nbFrames == 0) || (sound->rate <= 0)) {
+        fprintf (stderr, "%s : no sound\n", path);
+        sound_free (sound);
+        return 0;
+    }
+    return 1;
+}
+
+void sound_make (Sound *sound)
+{
+    unsigned int rnd = 12345;
+    long i;
+
+    memset (sound, 0, sizeof(Sound));
+    sound->rate = 44100;
+    sound->nbFrames = 441000;
+    sound->samples = (gint16 *) malloc (sound->nbFrames * 2 * sizeof(gint16));
+    for (i = 0; i < sound->nbFrames; ++i) {
+        float t = (float)i / 44100.0f;
+        float beat = expf (-fmodf (t, 0.5f) * 12.0f);
+        float note = sinf (t * 2.0f * 3.14159265f * (110.0f + 55.0f * floorf (fmodf (t, 4.0f))));
+        float noise;
+        rnd = rnd * 1664525u + 1013904223u;
+        noise = (float)(rnd >> 16) / 32768.0f - 1.0f;
+        sound->samples[2 * i] = clip16 ((note * 0.3f + noise * 0.6f * beat) * 32767.0f);
+        sound->samples[2 * i + 1] = clip16 ((note * 0.3f * beat + noise * 0.2f) * 32767.0f);
+    }
+}
+
+void sound_free (Sound *sound)
+{
+    free (sound->samples);
+    sound->samples = NULL;
+    sound->nbFrames = 0;
+}
+
+void sound_next_window (Sound *sound, gint16 data[NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN])
+{
+    int i;
+    for (i = 0; i < AUDIO_SAMPLE_LEN; ++i) {
+        data[0][i] = sound->samples[2 * sound->pos];
+        data[1][i] = sound->samples[2 * sound->pos + 1];
+        if (++sound->pos == sound->nbFrames)
+            sound->pos = 0;
+    }
+}
+
+void sound_window_at (const Sound *sound, long frame, gint16 data[NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN])
+{
+    int i;
+    for (i = 0; i < AUDIO_SAMPLE_LEN; ++i, ++frame) {
+        if ((frame >= 0) && (frame < sound->nbFrames)) {
+            data[0][i] = sound->samples[2 * frame];
+            data[1][i] = sound->samples[2 * frame + 1];
+        }
+        else
+            data[0][i] = data[1][i] = 0;
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef _SOUND_FILE_H
+#define _SOUND_FILE_H
+
+/*
+ * The sound given to goom by goom_bench and goom_render : a WAV (16 bits PCM
+ * or 32 bits float, mono or stereo) or raw PCM (16 bits signed, little
+ * endian, stereo, 44100 Hz), or a made up one.
+ */
+
+#include "goom.h"
+
+typedef struct {
+    gint16 *samples; /* interleaved, 2 channels */
+    long nbFrames;   /* of 2 samples */
+    int rate;        /* Hz */
+    long pos;        /* of sound_next_window */
+} Sound;
+
+/* 0 if it cannot be read, said on stderr */
+int sound_load (const char *path, Sound *sound);
+
+/* 10 s at 44100 Hz : a bass note, noise, and a beat every half second */
+void sound_make (Sound *sound);
+
+void sound_free (Sound *sound);
+
+/* the next AUDIO_SAMPLE_LEN samples of each channel, the way Kodi gives them.
+ * from the start again at the end */
+void sound_next_window (Sound *sound, gint16 data[NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN]);
+
+/* the AUDIO_SAMPLE_LEN samples from frame on, zeros after the end */
+void sound_window_at (const Sound *sound, long frame, gint16 data[NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN]);
+
+#endif
@@ -0,0 +1,207 @@
+/*
+ * zoom_bench : frame time (and cache misses, when the kernel lets us read
+ * them) of the zoom filter in each of the ten modes, line by line then by tiles.
+ *
+ * usage : zoom_bench [width height [frames]]
+ *
+ * The zoom runs on one thread so that the counters only see it.
+ * The "same" column checks that the tiles give the same picture.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "goom.h"
+#include "goom_filters.h"
+#include "goom_plugin_info.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int open_counter (unsigned int type, unsigned long long config)
+{
+    struct perf_event_attr attr;
+    memset (&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void start_counter (int fd)
+{
+    if (fd < 0) return;
+    ioctl (fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl (fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+static long long stop_counter (int fd)
+{
+    long long v = -1;
+    if (fd < 0) return -1;
+    ioctl (fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read (fd, &v, sizeof(v)) != sizeof(v))
+        return -1;
+    return v;
+}
+#else
+#define open_counter(type, config) (-1)
+#define start_counter(fd)
+#define stop_counter(fd) (-1LL)
+#endif
+
+static const char *modeNames[] = {
+    "NORMAL", "WAVE", "CRYSTAL_BALL", "SCRUNCH", "AMULETTE",
+    "WATER", "HYPERCOS1", "HYPERCOS2", "YONLY", "SPEEDWAY"
+};
+
+/* -1 : no counter */
+static const char *count_str (long long v, char *buf)
+{
+    if (v < 0)
+        return "n/a";
+    sprintf (buf, "%lld", v);
+    return buf;
+}
+
+static double now (void)
+{
+    struct timespec t;
+    timespec_get (&t, TIME_UTC);
+    return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+static PluginParam *zoom_param (PluginInfo *goom, const char *name)
+{
+    PluginParameters *params = goom->zoomFilter_fx.params;
+    int i;
+    for (i = 0; i < params->nbParams; ++i)
+        if (params->params[i] && !strcmp (params->params[i]->name, name))
+            return params->params[i];
+    fprintf (stderr, "no zoom param %s\n", name);
+    exit (1);
+}
+
+/* the alpha channel is left out, the fast kernels do not keep it */
+static unsigned int hash_rgb (const Pixel *p, int size)
+{
+    Pixel mask;
+    unsigned int h = 0;
+    int i;
+    mask.val = 0xffffffff;
+    mask.channels.a = 0;
+    for (i = 0; i < size; ++i)
+        h = h * 31 + (p[i].val & mask.val);
+    return h;
+}
+
+typedef struct {
+    double ms;
+    long long l1Misses, llcMisses;
+    unsigned int hash;
+} Run;
+
+static Run run_zoom (PluginInfo *goom, Pixel *src, Pixel *dest, int width, int height, int frames,
+                     int l1Fd, int llcFd)
+{
+    Run r;
+    int i;
+    double t;
+
+    start_counter (l1Fd);
+    start_counter (llcFd);
+    t = now ();
+    /* no new config, buffratio stays at 0 : always the same map */
+    for (i = 0; i < frames; ++i)
+        zoomFilterFastRGB (goom, src, dest, NULL, width, height, 0, 1.0f);
+    r.ms = (now () - t) * 1000.0 / frames;
+    r.l1Misses = stop_counter (l1Fd);
+    r.llcMisses = stop_counter (llcFd);
+    r.hash = hash_rgb (dest, width * height);
+    if (r.l1Misses >= 0) r.l1Misses /= frames;
+    if (r.llcMisses >= 0) r.llcMisses /= frames;
+    return r;
+}
+
+int main (int argc, char **argv)
+{
+    int width = (argc > 2) ? atoi (argv[1]) : 1280;
+    int height = (argc > 2) ? atoi (argv[2]) : 720;
+    int frames = (argc > 3) ? atoi (argv[3]) : 20;
+    int mode, i;
+
+    int l1Fd = open_counter (PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                             | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    int llcFd = open_counter (PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+
+    Pixel *src = (Pixel *) malloc (width * height * sizeof(Pixel));
+    Pixel *dest = (Pixel *) malloc (width * height * sizeof(Pixel));
+
+    if ((l1Fd < 0) || (llcFd < 0))
+        fprintf (stderr, "no cache counters (perf_event_open), only the times are given\n");
+
+    printf ("%dx%d, %d frames, per frame : ms, L1D read misses, LLC misses\n", width, height, frames);
+    printf ("%-13s %8s %11s %11s | %8s %11s %11s | %-9s %-9s %s\n", "mode",
+            "lines", "L1D", "LLC", "tiles", "L1D", "LLC", "tile", "tuned", "same");
+
+    for (mode = 0; mode < 10; ++mode) {
+        PluginInfo *goom = goom_init (width, height);
+        ZoomFilterData zf;
+        Run lines, tiles;
+        int tileW, tileH;
+        char buf[4][32], tile[2][16];
+
+        goom_set_threads (goom, 1);
+        for (i = 0; i < width * height; ++i)
+            src[i].val = (unsigned int)i * 2654435761u;
+
+        memset (&zf, 0, sizeof(zf));
+        zf.vitesse = 110;
+        zf.pertedec = 8;
+        zf.sqrtperte = 16;
+        zf.middleX = width / 2;
+        zf.middleY = height / 2;
+        zf.mode = mode;
+        zf.hypercosEffect = (mode == HYPERCOS1_MODE) || (mode == HYPERCOS2_MODE);
+
+        /* first frame : makes the map and tunes the tiles */
+        zoomFilterFastRGB (goom, src, dest, &zf, width, height, 0, 1.0f);
+        tileW = IVAL(*zoom_param (goom, "Tile Width"));
+        tileH = IVAL(*zoom_param (goom, "Tile Height"));
+
+        BVAL(*zoom_param (goom, "Tiled")) = 0;
+        lines = run_zoom (goom, src, dest, width, height, frames, l1Fd, llcFd);
+
+        /* the tuning may keep the lines, look at a tile size anyway */
+        BVAL(*zoom_param (goom, "Tiled")) = 1;
+        if ((tileW == 0) || (tileH == 0)) {
+            IVAL(*zoom_param (goom, "Tile Width")) = 64;
+            IVAL(*zoom_param (goom, "Tile Height")) = 32;
+        }
+        tiles = run_zoom (goom, src, dest, width, height, frames, l1Fd, llcFd);
+
+        sprintf (tile[0], "%dx%d", IVAL(*zoom_param (goom, "Tile Width")), IVAL(*zoom_param (goom, "Tile Height")));
+        if ((tileW == 0) || (tileH == 0))
+            sprintf (tile[1], "lines");
+        else
+            sprintf (tile[1], "%dx%d", tileW, tileH);
+        printf ("%-13s %8.2f %11s %11s | %8.2f %11s %11s | %-9s %-9s %s\n", modeNames[mode],
+                lines.ms, count_str (lines.l1Misses, buf[0]), count_str (lines.llcMisses, buf[1]),
+                tiles.ms, count_str (tiles.l1Misses, buf[2]), count_str (tiles.llcMisses, buf[3]),
+                tile[0], tile[1], (lines.hash == tiles.hash) ? "yes" : "NO");
+
+        goom_close (goom);
+    }
+
+    free (src);
+    free (dest);
+    return 0;
+}
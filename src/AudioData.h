@@ -19,6 +19,20 @@ static inline int16_t FloatToInt16(float f)
     return static_cast<int16_t>((f * static_cast<float>(INT16_MAX)));
 }
 
+int const silence_threshold = 8;
+
+// No sample beyond +-silence_threshold once converted to the samples goom gets.
+static inline bool IsSilentAudio(const float floatAudioData[], int len)
+{
+  for (int i = 0; i < len; i++)
+  {
+    const int16_t sample = FloatToInt16(floatAudioData[i]);
+    if (sample > silence_threshold || sample < -silence_threshold)
+      return false;
+  }
+  return true;
+}
+
 static inline void FillAudioDataBuffer(
     int16_t audioData[NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN],
     const float floatAudioData[NUM_AUDIO_SAMPLES * AUDIO_SAMPLE_LEN],
@@ -20,80 +20,179 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <vector>
 
-int const silence_threshold = 8;
+#if defined(__linux__)
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
 
+// Keeps the indices of the producer and of the consumer on their own cache lines.
+constexpr size_t cache_line_size = 64;
+
+// Wait-free ring for one producer thread and one consumer thread.
+// The size is rounded up to a power of two, the indices only grow and are masked.
 template<typename T>
-class circular_buffer
+class spsc_ring
 {
 public:
-  circular_buffer(unsigned p_size) : readptr(0), writeptr(0), size(p_size), used(0)
+  explicit spsc_ring(size_t p_size) : mask(round_up_pow2(p_size) - 1), buffer(mask + 1) {}
+
+  size_t capacity() const { return mask + 1; }
+  size_t data_available() const
   {
-    buffer.resize(p_size);
+    return writeptr.load(std::memory_order_acquire) - readptr.load(std::memory_order_acquire);
   }
-  unsigned data_available() { return used; }
-  unsigned free_space() { return size - used; }
-  bool write(const T* src, unsigned count)
+
+  // Producer side: all or nothing, false when there is not enough room.
+  bool write(const T* src, size_t count)
   {
-    if (count > free_space())
-      return false;
-    while (count)
+    const size_t w = writeptr.load(std::memory_order_relaxed);
+    if (w + count - cached_readptr > capacity())
     {
-      unsigned delta = size - writeptr;
-      if (delta > count)
-        delta = count;
-      std::copy(src, src + delta, buffer.begin() + writeptr);
-      used += delta;
-      writeptr = (writeptr + delta) % size;
-      src += delta;
-      count -= delta;
+      cached_readptr = readptr.load(std::memory_order_acquire);
+      if (w + count - cached_readptr > capacity())
+        return false;
     }
+    const size_t start = w & mask;
+    const size_t first = std::min(count, capacity() - start);
+    std::copy(src, src + first, buffer.begin() + start);
+    std::copy(src + first, src + count, buffer.begin());
+    writeptr.store(w + count, std::memory_order_release);
     return true;
   }
-  unsigned read(T* dst, unsigned count)
+
+  // Consumer side: returns the number of items read, at most count.
+  size_t read(T* dst, size_t count)
   {
-    unsigned done = 0;
-    for (;;)
+    const size_t r = readptr.load(std::memory_order_relaxed);
+    if (cached_writeptr - r < count)
     {
-      unsigned delta = size - readptr;
-      if (delta > used)
-        delta = used;
-      if (delta > count)
-        delta = count;
-      if (!delta)
-        break;
-
-      std::copy(buffer.begin() + readptr, buffer.begin() + readptr + delta, dst);
-      dst += delta;
-      done += delta;
-      readptr = (readptr + delta) % size;
-      count -= delta;
-      used -= delta;
+      cached_writeptr = writeptr.load(std::memory_order_acquire);
+      count = std::min(count, cached_writeptr - r);
     }
-    return done;
+    const size_t start = r & mask;
+    const size_t first = std::min(count, capacity() - start);
+    std::copy(buffer.begin() + start, buffer.begin() + start + first, dst);
+    std::copy(buffer.begin(), buffer.begin() + (count - first), dst + first);
+    readptr.store(r + count, std::memory_order_release);
+    return count;
   }
-  void reset() { readptr = writeptr = used = 0; }
-  void resize(unsigned p_size)
+
+private:
+  static size_t round_up_pow2(size_t n)
   {
-    size = p_size;
-    buffer.resize(p_size);
-    reset();
+    size_t p = 1;
+    while (p < n)
+      p <<= 1;
+    return p;
   }
-  bool test_silence() const
+
+  const size_t mask;
+  std::vector<T> buffer;
+
+  // Written by the producer.
+  char pad0[cache_line_size];
+  std::atomic<size_t> writeptr{0};
+  size_t cached_readptr = 0;
+
+  // Written by the consumer.
+  char pad1[cache_line_size];
+  std::atomic<size_t> readptr{0};
+  size_t cached_writeptr = 0;
+  char pad2[cache_line_size];
+};
+
+// Wakes up a thread waiting for a ring without a lock on the notifying side:
+// a futex on Linux, a condition variable elsewhere, only touched when someone sleeps.
+//
+// The waiting side takes a key before looking at its condition, then waits on that key:
+//   key = event.prepare_wait(); if (!ready()) event.wait(key);
+class ring_event
+{
+public:
+  uint32_t prepare_wait() const { return seq.load(std::memory_order_seq_cst); }
+
+  void wait(uint32_t key)
+  {
+    waiters.fetch_add(1, std::memory_order_seq_cst);
+#if defined(__linux__)
+    while (seq.load(std::memory_order_seq_cst) == key)
+      syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq), FUTEX_WAIT_PRIVATE, key, nullptr,
+              nullptr, 0);
+#else
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cond.wait(lock, [&] { return seq.load(std::memory_order_seq_cst) != key; });
+    }
+#endif
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  // Same as wait, false when nothing was notified within timeout.
+  bool wait_for(uint32_t key, std::chrono::microseconds timeout)
   {
-    T* begin = (T*)&buffer[0];
-    T first = *begin;
-    *begin = silence_threshold * 2;
-    T* p = begin + size;
-    while ((unsigned)(*--p + silence_threshold) <= (unsigned)silence_threshold * 2)
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    bool notified = true;
+    waiters.fetch_add(1, std::memory_order_seq_cst);
+#if defined(__linux__)
+    while (seq.load(std::memory_order_seq_cst) == key)
     {
+      const auto left = deadline - std::chrono::steady_clock::now();
+      if (left <= std::chrono::steady_clock::duration::zero())
+      {
+        notified = false;
+        break;
+      }
+      const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(left);
+      timespec relative;
+      relative.tv_sec = static_cast<time_t>(seconds.count());
+      relative.tv_nsec = static_cast<long>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(left - seconds).count());
+      syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq), FUTEX_WAIT_PRIVATE, key, &relative,
+              nullptr, 0);
+    }
+#else
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      notified = cond.wait_until(lock, deadline,
+                                 [&] { return seq.load(std::memory_order_seq_cst) != key; });
     }
-    *begin = first;
-    return p == begin && ((unsigned)(first + silence_threshold) <= (unsigned)silence_threshold * 2);
+#endif
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+    return notified;
+  }
+
+  void notify()
+  {
+    seq.fetch_add(1, std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_seq_cst) == 0)
+      return;
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr,
+            nullptr, 0);
+#else
+    std::lock_guard<std::mutex> lock(mutex);
+    cond.notify_all();
+#endif
   }
 
 private:
-  std::vector<T> buffer;
-  unsigned readptr, writeptr, used, size;
+  std::atomic<uint32_t> seq{0};
+  std::atomic<uint32_t> waiters{0};
+#if defined(__linux__)
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "the futex word is seq itself");
+#else
+  std::mutex mutex;
+  std::condition_variable cond;
+#endif
 };
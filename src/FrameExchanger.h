@@ -0,0 +1,183 @@
+/*
+ *      Copyright (C) 2020 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "CircularBuffer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+// Frames handed from one producer thread (goom) to one consumer thread (the renderer),
+// without a lock. All the frames are allocated up front.
+//
+// queued_frames == 0: triple buffering, the latest complete frame wins and the
+//   older ones are dropped.
+// queued_frames > 0: a FIFO of up to queued_frames frames, the producer gets no
+//   frame to draw into while it is full.
+//
+// The producer may change the content of the frame it acquired before publishing it
+// (cf goom_give_screenbuffer, which may give another pixel buffer back).
+template<typename Frame>
+class frame_exchanger
+{
+public:
+  // All the frames that are allocated.
+  static size_t frame_count(size_t queued_frames)
+  {
+    return queued_frames == 0 ? 3 : queued_frames + 2;
+  }
+
+  frame_exchanger(size_t queued_frames,
+                  const std::function<Frame*()>& alloc_frame,
+                  void (*free_frame)(Frame*))
+    : queued(queued_frames),
+      free_frame(free_frame),
+      full(queued_frames + 2),
+      empty(queued_frames + 2)
+  {
+    // all the frames start black, the one consumed first is the initial screen
+    front = alloc_frame();
+    if (queued == 0)
+    {
+      middle.store(reinterpret_cast<uintptr_t>(alloc_frame()) | fresh_bit);
+      back = alloc_frame();
+      return;
+    }
+    Frame* frame = alloc_frame();
+    full.write(&frame, 1);
+    for (size_t i = 0; i < queued; i++)
+    {
+      frame = alloc_frame();
+      empty.write(&frame, 1);
+    }
+  }
+
+  frame_exchanger(const frame_exchanger&) = delete;
+  frame_exchanger& operator=(const frame_exchanger&) = delete;
+
+  // Both threads must be done with it.
+  ~frame_exchanger()
+  {
+    Frame* frame;
+    release(front);
+    release(back);
+    release(reinterpret_cast<Frame*>(middle.load() & ~fresh_bit));
+    while (full.read(&frame, 1))
+      release(frame);
+    while (empty.read(&frame, 1))
+      release(frame);
+  }
+
+  // Producer: the frame to draw into, nullptr when the FIFO is full (the frame is dropped).
+  Frame* acquire()
+  {
+    if (back == nullptr && !empty.read(&back, 1))
+    {
+      dropped_frames.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    return back;
+  }
+
+  // Producer: hands the acquired frame over once complete.
+  void publish(Frame* frame)
+  {
+    if (queued > 0)
+    {
+      full.write(&frame, 1);
+      back = nullptr;
+      return;
+    }
+    const uintptr_t old =
+        middle.exchange(reinterpret_cast<uintptr_t>(frame) | fresh_bit, std::memory_order_acq_rel);
+    if (old & fresh_bit)
+      dropped_frames.fetch_add(1, std::memory_order_relaxed);
+    back = reinterpret_cast<Frame*>(old & ~fresh_bit);
+  }
+
+  // Consumer: the next frame to show, nullptr when there is none (the last one is shown again).
+  // The frame stays valid until the next call.
+  Frame* consume()
+  {
+    if (queued > 0)
+    {
+      Frame* frame;
+      if (!full.read(&frame, 1))
+      {
+        repeated_frames.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+      }
+      empty.write(&front, 1);
+      front = frame;
+      return front;
+    }
+    if (!(middle.load(std::memory_order_relaxed) & fresh_bit))
+    {
+      repeated_frames.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    const uintptr_t old =
+        middle.exchange(reinterpret_cast<uintptr_t>(front), std::memory_order_acq_rel);
+    front = reinterpret_cast<Frame*>(old & ~fresh_bit);
+    return front;
+  }
+
+  // Consumer: true when consume() would return a frame.
+  bool pending() const
+  {
+    if (queued > 0)
+      return full.data_available() > 0;
+    return (middle.load(std::memory_order_acquire) & fresh_bit) != 0;
+  }
+
+  // Frames made but never shown (or not made at all when the FIFO was full).
+  uint64_t dropped() const { return dropped_frames.load(std::memory_order_relaxed); }
+  // Times the consumer had nothing new to show.
+  uint64_t repeated() const { return repeated_frames.load(std::memory_order_relaxed); }
+
+private:
+  // set in middle when its frame has not been consumed yet, the frames are at least 2 bytes aligned
+  static constexpr uintptr_t fresh_bit = 1;
+
+  void release(Frame* frame)
+  {
+    if (frame != nullptr)
+      free_frame(frame);
+  }
+
+  const size_t queued;
+  void (*const free_frame)(Frame*);
+
+  // Triple buffering: back is the producer's, front the consumer's, they swap with middle.
+  Frame* back = nullptr;
+  char pad0[cache_line_size];
+  std::atomic<uintptr_t> middle{0};
+  char pad1[cache_line_size];
+  Frame* front = nullptr;
+
+  // FIFO: the frames to show, and those already shown.
+  spsc_ring<Frame*> full;
+  spsc_ring<Frame*> empty;
+
+  std::atomic<uint64_t> dropped_frames{0};
+  char pad2[cache_line_size];
+  std::atomic<uint64_t> repeated_frames{0};
+};
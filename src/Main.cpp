@@ -23,6 +23,54 @@
 
 #include "AudioData.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <kodi/Filesystem.h>
+
+namespace
+{
+// Silence fades goom out after this, then it stops once its frame does not change anymore.
+const std::chrono::seconds g_silenceBeforeFade(3);
+const std::chrono::seconds g_fadeTime(2);
+const int g_staticFramesBeforeIdle = 8;
+// Without any audio (a paused stream), it is silence after this.
+const std::chrono::milliseconds g_noAudioTimeout(250);
+
+// Enough to tell whether a frame changed.
+uint64_t FrameChecksum(const uint32_t* pixels, size_t count)
+{
+  uint64_t sum = 0;
+  for (size_t i = 0; i < count; i++)
+    sum = (sum ^ pixels[i]) * 0x100000001b3ULL;
+  return sum;
+}
+
+// Events kept for the trace: the last minutes at 60 fps.
+const size_t g_traceEvents = 1 << 18;
+
+#ifdef GOOM_PROFILE
+// Where goom's time goes, over its last frames.
+const unsigned long g_stageStatsFrames = 1000;
+
+void LogStageStats(PluginInfo* goom)
+{
+  GoomStageStats stats[GOOM_NB_STAGES];
+  const int frames = goom_get_stage_stats(goom, stats);
+  std::string line;
+  for (int stage = 0; stage < GOOM_NB_STAGES; stage++)
+  {
+    char stageLine[64];
+    snprintf(stageLine, sizeof(stageLine), " %s %.0f/%.0f", goom_stage_name(stage),
+             stats[stage].mean, stats[stage].max);
+    line += stageLine;
+  }
+  kodi::Log(ADDON_LOG_DEBUG, "Process: us per stage (mean/max of %d frames):%s", frames,
+            line.c_str());
+}
+#endif
+} // namespace
+
 CVisualizationGoom::CVisualizationGoom()
 {
   switch (kodi::GetSettingInt("quality"))
@@ -39,6 +87,12 @@ CVisualizationGoom::CVisualizationGoom()
       m_tex_width = 1280;
       m_tex_height = 720;
       break;
+    case 3:
+      // up to 1280x720, as much as the machine keeps up with
+      m_tex_width = 1280;
+      m_tex_height = 720;
+      m_adaptiveQuality = true;
+      break;
     default:
       m_tex_width = GOOM_TEXTURE_WIDTH;
       m_tex_height = GOOM_TEXTURE_HEIGHT;
@@ -48,6 +102,12 @@ CVisualizationGoom::CVisualizationGoom()
   m_goomBufferLen = m_tex_width * m_tex_height;
   m_goomBufferSize = m_goomBufferLen * sizeof(uint32_t);
 
+  m_numThreads = kodi::GetSettingInt("threads");
+  m_queuedFrames = kodi::GetSettingInt("queued_frames");
+  m_targetFps = kodi::GetSettingInt("target_fps");
+  m_idleOnSilence = kodi::GetSettingBoolean("idle_on_silence");
+  m_traceEnabled = kodi::GetSettingBoolean("trace");
+
 #ifdef HAS_GL
   m_usePixelBufferObjects = kodi::GetSettingBoolean("use_pixel_buffer_objects");
 #endif
@@ -86,15 +146,11 @@ bool CVisualizationGoom::Start(int iChannels,
   }
 
   m_channels = iChannels;
+  m_samplesPerSec = iSamplesPerSec > 0 ? iSamplesPerSec : 44100;
   m_audioBufferLen = m_channels * AUDIO_SAMPLE_LEN;
   m_currentSongName = szSongName;
   m_titleChange = true;
 
-  // Make one init frame in black
-  std::shared_ptr<uint32_t> sp(new uint32_t[m_goomBufferLen], std::default_delete<uint32_t[]>());
-  memset(sp.get(), 0, m_goomBufferSize);
-  m_activeQueue.push(sp);
-
   // Init GL parts
   if (!LoadShaderFiles(kodi::GetAddonPath("resources/shaders/" GL_TYPE_STRING "/vert.glsl"),
                        kodi::GetAddonPath("resources/shaders/" GL_TYPE_STRING "/frag.glsl")))
@@ -115,7 +171,69 @@ bool CVisualizationGoom::Start(int iChannels,
     return false;
   }
 
+  m_goom = goom_init(m_tex_width, m_tex_height);
+  if (!m_goom)
+  {
+    kodi::Log(ADDON_LOG_FATAL, "Start: Goom could not be initialized!");
+    return false;
+  }
+  goom_set_threads(m_goom, m_numThreads);
+
+  // All the frames are made now, of the biggest size, the first one shown is black
+  m_shownFrame = nullptr;
+#ifdef HAS_GL
+  if (m_usePixelBufferObjects)
+  {
+    m_framesFromGoom = false;
+    m_frames.reset(new frame_exchanger<screen_frame>(
+        m_queuedFrames,
+        [this] {
+          screen_frame* frame = m_pixelBuffers.next_frame();
+          frame->width = m_tex_width;
+          frame->height = m_tex_height;
+          return frame;
+        },
+        [](screen_frame*) {}));
+  }
+  else
+#endif
+  {
+    // goom's pool makes all their buffers side by side, nothing is allocated after this
+    const size_t numFrames = frame_exchanger<screen_frame>::frame_count(m_queuedFrames);
+    size_t nextFrame = 0;
+    m_framesFromGoom = true;
+    m_goomFrames.assign(numFrames, screen_frame());
+    goom_reserve_screenbuffers(m_goom, static_cast<int>(numFrames));
+    m_frames.reset(new frame_exchanger<screen_frame>(
+        m_queuedFrames,
+        [this, &nextFrame] {
+          screen_frame* frame = &m_goomFrames[nextFrame++];
+          frame->pixels = static_cast<uint32_t*>(goom_alloc_screenbuffer(m_goom));
+          frame->width = m_tex_width;
+          frame->height = m_tex_height;
+          return frame;
+        },
+        [](screen_frame* frame) { goom_free_screenbuffer(frame->pixels); }));
+  }
+
+  // goom and the frames keep their buffers of the biggest size, smaller ones fit in them
+  if (m_adaptiveQuality)
+  {
+    m_governor.reset(new resolution_governor(
+        m_tex_width, m_tex_height, std::chrono::microseconds(1000000 / m_targetFps)));
+    goom_set_resolution(m_goom, m_governor->current().width, m_governor->current().height);
+  }
+
+  // goom's stages and zoom maps, goom is built with GOOM_PROFILE by default
+  m_trace.reset();
+  if (m_traceEnabled)
+  {
+    m_trace.reset(new trace_recorder(g_traceEvents));
+    goom_set_stage_listener(m_goom, &CVisualizationGoom::OnGoomStage, this);
+  }
+
   // Start the goom process thread
+  m_idle = false;
   kodi::Log(ADDON_LOG_DEBUG, "Start: Setting up buffer worker thread.");
   m_workerThread = std::thread(&CVisualizationGoom::Process, this);
 
@@ -137,16 +255,42 @@ void CVisualizationGoom::Stop()
   m_started = false;
 
   kodi::Log(ADDON_LOG_DEBUG, "Stop: Stopping processed buffers thread...");
-  {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    m_threadExit = true;
-    m_wait.notify_one();
-  }
+  m_threadExit = true;
+  m_audioEvent.notify();
   if (m_workerThread.joinable())
     m_workerThread.join();
 
   kodi::Log(ADDON_LOG_DEBUG, "Stop: Processed buffers thread stopped.");
 
+  kodi::Log(ADDON_LOG_DEBUG, "Stop: %llu frames dropped, %llu frames repeated.",
+            static_cast<unsigned long long>(m_frames->dropped()),
+            static_cast<unsigned long long>(m_frames->repeated()));
+
+  if (m_trace)
+  {
+    const std::string path = kodi::vfs::TranslateSpecialProtocol("special://temp/goom-trace.json");
+    if (m_trace->write(path))
+      kodi::Log(ADDON_LOG_INFO, "Stop: Trace of %llu events written to %s.",
+                static_cast<unsigned long long>(m_trace->recorded()), path.c_str());
+    else
+      kodi::Log(ADDON_LOG_ERROR, "Stop: Could not write the trace to %s.", path.c_str());
+  }
+  m_frames.reset();
+  m_goomFrames.clear();
+  m_governor.reset();
+
+  kodi::Log(ADDON_LOG_DEBUG, "Stop: %llu MB of frame buffers.",
+            static_cast<unsigned long long>(goom_memory_footprint(m_goom) >> 20));
+  goom_close(m_goom);
+  m_goom = nullptr;
+
+#ifdef HAS_GL
+  if (m_usePixelBufferObjects)
+  {
+    m_pixelBuffers.destroy();
+  }
+#endif
+
   glDeleteTextures(1, &m_textureId);
   m_textureId = 0;
 
@@ -182,14 +326,22 @@ void CVisualizationGoom::AudioData(const float* pAudioData,
     return;
   }
 
-  std::unique_lock<std::mutex> lock(m_mutex);
-  if (m_buffer.data_available() >= g_circular_buffer_size)
+  trace_recorder* const trace = m_trace.get();
+  const auto start = trace_recorder::clock::now();
+  if (trace)
+    trace->name_thread("audio");
+
+  // Never blocks: when the goom thread is too far behind, the data is dropped.
+  if (!m_buffer.write(pAudioData, iAudioDataLength))
   {
+    if (trace)
+      trace->instant("audio dropped");
     return;
   }
+  m_audioEvent.notify();
 
-  m_buffer.write(pAudioData, iAudioDataLength);
-  m_wait.notify_one();
+  if (trace)
+    trace->complete("AudioData", start);
 }
 
 bool CVisualizationGoom::UpdateTrack(const VisTrack& track)
@@ -220,7 +372,8 @@ bool CVisualizationGoom::UpdateTrack(const VisTrack& track)
 
 bool CVisualizationGoom::IsDirty()
 {
-  return true; //!m_worker.RequestsQueueEmpty();
+  // Nothing to draw again once goom is idle and its last frame is shown.
+  return !m_started || !m_idle || m_frames->pending();
 }
 
 void CVisualizationGoom::Render()
@@ -231,6 +384,11 @@ void CVisualizationGoom::Render()
     return;
   }
 
+  trace_recorder* const trace = m_trace.get();
+  const auto start = trace_recorder::clock::now();
+  if (trace)
+    trace->name_thread("render");
+
   // Setup vertex attributes.
 #ifdef HAS_GL
   glBindVertexArray(m_vaoObject);
@@ -247,35 +405,43 @@ void CVisualizationGoom::Render()
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, m_textureId);
 
-  std::shared_ptr<uint32_t> pixels = GetNextActivePixels();
-  if (pixels != nullptr)
+  // The frame shown until now goes back to the goom thread with the next one,
+  // a PBO only once its upload is done.
+  screen_frame* frame = nullptr;
+#ifdef HAS_GL
+  if (!m_usePixelBufferObjects || m_shownFrame == nullptr ||
+      m_pixelBuffers.writable(m_shownFrame))
+#endif
+  {
+    frame = m_frames->consume();
+  }
+  if (frame != nullptr)
   {
+    const auto uploadStart = trace_recorder::clock::now();
+    if (trace)
+      trace->instant("consume", frame->number);
+    m_shownFrame = frame;
+    // goom changed its resolution, the quad scales the texture to the window
+    if (frame->width != m_shownWidth || frame->height != m_shownHeight)
+    {
+      m_shownWidth = frame->width;
+      m_shownHeight = frame->height;
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_shownWidth, m_shownHeight, 0, GL_RGBA,
+                   GL_UNSIGNED_BYTE, 0);
+    }
 #ifdef HAS_GL
     if (m_usePixelBufferObjects)
     {
-      m_currentPboIndex = (m_currentPboIndex + 1) % g_numPbos;
-      const int nextPboIndex = (m_currentPboIndex + 1) % g_numPbos;
-
-      // Bind to current PBO and send pixels to texture object.
-      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pboIds[m_currentPboIndex]);
-      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_tex_width, m_tex_height, GL_RGBA, GL_UNSIGNED_BYTE,
-                      0);
-
-      // Bind to next PBO and update data directly on the mapped buffer.
-      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pboIds[nextPboIndex]);
-      std::memcpy(m_pboGoomBuffer[nextPboIndex], pixels.get(), m_goomBufferSize);
-
-      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER); // release pointer to mapping buffer
-      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      m_pixelBuffers.upload(frame, frame->width, frame->height);
     }
     else
 #endif
     {
-      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_tex_width, m_tex_height, GL_RGBA, GL_UNSIGNED_BYTE,
-                      pixels.get());
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, frame->width, frame->height, GL_RGBA,
+                      GL_UNSIGNED_BYTE, frame->pixels);
     }
-
-    PushUsedPixels(pixels);
+    if (trace)
+      trace->complete("upload", uploadStart, frame->number);
   }
 
   EnableShader();
@@ -290,59 +456,104 @@ void CVisualizationGoom::Render()
   glDisableVertexAttribArray(m_aPositionLoc);
   glDisableVertexAttribArray(m_aCoordLoc);
 #endif
-}
 
-inline std::shared_ptr<uint32_t> CVisualizationGoom::GetNextActivePixels()
-{
-  std::shared_ptr<uint32_t> pixels(nullptr);
-  std::lock_guard<std::mutex> lk(m_mutex);
-  if (!m_activeQueue.empty())
-  {
-    pixels = m_activeQueue.front();
-    m_activeQueue.pop();
-  }
-  return pixels;
+  if (trace)
+    trace->complete("Render", start);
 }
 
-inline void CVisualizationGoom::PushUsedPixels(std::shared_ptr<uint32_t> pixels)
+void CVisualizationGoom::OnGoomStage(void* arg, int stage, unsigned int ns)
 {
-  std::lock_guard<std::mutex> lk(m_mutex);
-  m_storedQueue.push(pixels);
+  CVisualizationGoom* const self = static_cast<CVisualizationGoom*>(arg);
+  if (stage == GOOM_STAGE_ZOOM_MAP)
+    self->m_trace->name_thread("goom zoom map");
+  self->m_trace->complete(goom_stage_name(stage), std::chrono::nanoseconds(ns),
+                          self->m_traceFrame.load(std::memory_order_relaxed));
 }
 
 void CVisualizationGoom::Process()
 {
-  m_goom = goom_init(m_tex_width, m_tex_height);
-  if (!m_goom)
-  {
-    kodi::Log(ADDON_LOG_FATAL, "CVisualizationGoom: Goom could not be initialized!");
-    return;
-  }
-
   float floatAudioData[m_audioBufferLen];
   const char* title = nullptr;
   unsigned long buffNum = 0;
+  trace_recorder* const trace = m_trace.get();
+  if (trace)
+    trace->name_thread("goom");
+
+  // Silence is counted in audio time, made up one window at a time without audio.
+  const std::chrono::microseconds windowTime(1000000LL * AUDIO_SAMPLE_LEN / m_samplesPerSec);
+  std::chrono::microseconds silenceTime(0);
+  float fade = 1.0f;
+  uint64_t lastChecksum = 0;
+  int staticFrames = 0;
 
   while (true)
   {
-    std::unique_lock<std::mutex> lk(m_mutex);
     if (m_threadExit)
     {
       break;
     }
+    bool noAudio = false;
     if (m_buffer.data_available() < m_audioBufferLen)
     {
-      m_wait.wait(lk);
+      const uint32_t key = m_audioEvent.prepare_wait();
+      if (m_buffer.data_available() < m_audioBufferLen && !m_threadExit)
+      {
+        const auto waitStart = trace_recorder::clock::now();
+        if (!m_idleOnSilence || m_idle)
+        {
+          m_audioEvent.wait(key);
+        }
+        else
+        {
+          noAudio = !m_audioEvent.wait_for(
+                        key, silenceTime.count() > 0 ? windowTime : g_noAudioTimeout) &&
+                    m_buffer.data_available() < m_audioBufferLen;
+        }
+        if (trace)
+          trace->complete("wait audio", waitStart);
+      }
+      if (!noAudio)
+      {
+        continue;
+      }
+      std::fill(floatAudioData, floatAudioData + m_audioBufferLen, 0.0f);
     }
-    unsigned read = m_buffer.read(floatAudioData, m_audioBufferLen);
-    if (read != m_audioBufferLen)
+    else
     {
-      kodi::Log(ADDON_LOG_WARNING,
-                "Process: Read audio data %u != %d = expected audio data length - skipping this.",
-                read, m_audioBufferLen);
-      continue;
+      m_buffer.read(floatAudioData, m_audioBufferLen);
+    }
+
+    if (m_idleOnSilence)
+    {
+      if (!IsSilentAudio(floatAudioData, m_audioBufferLen))
+      {
+        // Sound again, goom goes on with this window at full brightness.
+        if (m_idle)
+        {
+          kodi::Log(ADDON_LOG_DEBUG, "Process: Sound again, leaving idle.");
+        }
+        silenceTime = std::chrono::microseconds(0);
+        staticFrames = 0;
+        m_idle = false;
+        fade = 1.0f;
+        goom_set_fade(m_goom, fade);
+      }
+      else if (m_idle)
+      {
+        continue;
+      }
+      else
+      {
+        silenceTime += windowTime;
+        if (silenceTime > g_silenceBeforeFade)
+        {
+          fade = 1.0f - static_cast<float>((silenceTime - g_silenceBeforeFade).count()) /
+                            std::chrono::microseconds(g_fadeTime).count();
+          fade = std::max(fade, 0.0f);
+          goom_set_fade(m_goom, fade);
+        }
+      }
     }
-    lk.unlock();
 
     if (m_titleChange || m_showTitleAlways)
     {
@@ -359,48 +570,72 @@ void CVisualizationGoom::Process()
       break;
     }
 
-    lk.lock();
-    if (m_activeQueue.size() > g_maxActiveQueueLength)
+    screen_frame* frame = m_frames->acquire();
+    if (frame == nullptr)
     {
       // Too far behind, skip this audio data.
+      if (trace)
+        trace->instant("no free frame", buffNum);
       continue;
     }
-    lk.unlock();
+    m_traceFrame.store(buffNum, std::memory_order_relaxed);
+
+    // When the frame needs no output pass, goom hands back its own buffer and keeps ours.
+    const auto start = std::chrono::steady_clock::now();
+    frame->pixels = UpdateGoomBuffer(title, floatAudioData, frame->pixels);
+    const auto frameTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    frame->width = m_goom->screen.width;
+    frame->height = m_goom->screen.height;
+    frame->number = buffNum;
+    m_frames->publish(frame);
+    if (trace)
+      trace->instant("publish", buffNum);
+    buffNum++;
 
-    std::shared_ptr<uint32_t> pixels;
-    lk.lock();
-    if (!m_storedQueue.empty())
+    // Faded out, goom is idle once its frame does not change anymore (black, maybe the title).
+    if (fade == 0.0f)
     {
-      pixels = m_storedQueue.front();
-      m_storedQueue.pop();
+      const uint64_t checksum =
+          FrameChecksum(frame->pixels, static_cast<size_t>(frame->width) * frame->height);
+      staticFrames = (checksum == lastChecksum) ? staticFrames + 1 : 0;
+      lastChecksum = checksum;
+      if (staticFrames >= g_staticFramesBeforeIdle)
+      {
+        kodi::Log(ADDON_LOG_DEBUG, "Process: Silence, idle after %lu frames.", buffNum);
+        m_idle = true;
+      }
     }
-    else
+
+#ifdef GOOM_PROFILE
+    if (buffNum % g_stageStatsFrames == 0)
     {
-      std::shared_ptr<uint32_t> sp(new uint32_t[m_goomBufferLen],
-                                   std::default_delete<uint32_t[]>());
-      pixels = sp;
+      LogStageStats(m_goom);
     }
-    lk.unlock();
-
-    UpdateGoomBuffer(title, floatAudioData, pixels.get());
-    buffNum++;
+#endif
 
-    lk.lock();
-    m_activeQueue.push(pixels);
-    lk.unlock();
+    // The next frames at another resolution, goom keeps its buffers.
+    if (m_governor && m_governor->update(frameTime))
+    {
+      const resolution_governor::resolution& res = m_governor->current();
+      kodi::Log(ADDON_LOG_DEBUG, "Process: %d us per frame, going to %dx%d.",
+                static_cast<int>(frameTime.count()), res.width, res.height);
+      goom_set_resolution(m_goom, res.width, res.height);
+    }
   }
-
-  goom_close(m_goom);
 }
 
-void CVisualizationGoom::UpdateGoomBuffer(const char* title,
-                                          const float floatAudioData[],
-                                          uint32_t* pixels)
+uint32_t* CVisualizationGoom::UpdateGoomBuffer(const char* title,
+                                               const float floatAudioData[],
+                                               uint32_t* pixels)
 {
   static int16_t audioData[NUM_AUDIO_SAMPLES][AUDIO_SAMPLE_LEN];
   FillAudioDataBuffer(audioData, floatAudioData, m_channels);
-  goom_set_screenbuffer(m_goom, pixels);
-  goom_update(m_goom, audioData, 0, 0.0f, title, "Kodi");
+  if (!m_framesFromGoom || !goom_give_screenbuffer(m_goom, pixels))
+  {
+    goom_set_screenbuffer(m_goom, pixels);
+  }
+  return goom_update(m_goom, audioData, 0, 0.0f, title, "Kodi");
 }
 
 void CVisualizationGoom::InitQuadData()
@@ -482,6 +717,8 @@ bool CVisualizationGoom::InitGLObjects()
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_tex_width, m_tex_height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
                0);
   glBindTexture(GL_TEXTURE_2D, 0);
+  m_shownWidth = m_tex_width;
+  m_shownHeight = m_tex_height;
 
 #ifdef HAS_GL
   if (!m_usePixelBufferObjects)
@@ -490,26 +727,15 @@ bool CVisualizationGoom::InitGLObjects()
   }
   else
   {
-    kodi::Log(ADDON_LOG_NOTICE, "InitGLObjects: Using pixel buffer objects.");
-    m_currentPboIndex = 0;
-
-    glGenBuffers(g_numPbos, m_pboIds);
-    for (int i = 0; i < g_numPbos; i++)
+    // goom draws into them, one per frame of m_frames
+    if (!m_pixelBuffers.create(frame_exchanger<screen_frame>::frame_count(m_queuedFrames),
+                               m_goomBufferSize))
     {
-      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pboIds[i]);
-      glBufferData(GL_PIXEL_UNPACK_BUFFER, m_goomBufferSize, 0, GL_STREAM_DRAW);
-      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pboIds[i]);
-      glBufferData(GL_PIXEL_UNPACK_BUFFER, m_goomBufferSize, 0, GL_STREAM_DRAW);
-      m_pboGoomBuffer[i] =
-          static_cast<unsigned char*>(glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY));
-      if (!m_pboGoomBuffer[i])
-      {
-        kodi::Log(ADDON_LOG_ERROR, "InitGLObjects: Could not do glMapBuffer for pbo %d.", i);
-        return false;
-      }
+      kodi::Log(ADDON_LOG_ERROR, "InitGLObjects: Could not map the pixel buffer objects.");
+      return false;
     }
-    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER); // release pointer to mapping buffer
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    kodi::Log(ADDON_LOG_NOTICE, "InitGLObjects: Using %s pixel buffer objects.",
+              m_pixelBuffers.is_persistent() ? "persistently mapped" : "mapped per frame");
   }
 #endif
 
@@ -22,6 +22,10 @@
 #define __STDC_LIMIT_MACROS
 
 #include "CircularBuffer.h"
+#include "FrameExchanger.h"
+#include "PixelBufferRing.h"
+#include "ResolutionGovernor.h"
+#include "TraceRecorder.h"
 
 extern "C"
 {
@@ -29,7 +33,7 @@ extern "C"
 #include "goom_config.h"
 }
 
-#include <condition_variable>
+#include <atomic>
 #include <functional>
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
@@ -37,10 +41,10 @@ extern "C"
 #include <kodi/General.h>
 #include <kodi/addon-instance/Visualization.h>
 #include <kodi/gui/gl/Shader.h>
-#include <mutex>
-#include <queue>
+#include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 #define GOOM_TEXTURE_WIDTH 1280
 #define GOOM_TEXTURE_HEIGHT 720
@@ -68,20 +72,31 @@ public:
   bool OnEnabled() override;
 
 protected:
-  virtual void UpdateGoomBuffer(const char* title, const float floatAudioData[], uint32_t* pixels);
+  // Gives pixels to goom, returns the buffer of the new frame (maybe not pixels).
+  virtual uint32_t* UpdateGoomBuffer(const char* title,
+                                     const float floatAudioData[],
+                                     uint32_t* pixels);
   int m_goomBufferLen;
   int m_audioBufferLen;
 
 private:
   void Process();
+  static void OnGoomStage(void* arg, int stage, unsigned int ns);
   bool InitGLObjects();
   void InitQuadData();
-  std::shared_ptr<uint32_t> GetNextActivePixels();
-  void PushUsedPixels(std::shared_ptr<uint32_t> pixels);
 
+  // the biggest size of the frames, the texture has the size of the one shown
   int m_tex_width = GOOM_TEXTURE_WIDTH;
   int m_tex_height = GOOM_TEXTURE_HEIGHT;
+  int m_shownWidth = 0;
+  int m_shownHeight = 0;
   size_t m_goomBufferSize;
+  int m_numThreads = 0; // 0 means one goom thread per cpu
+  int m_queuedFrames = 0; // 0 means only the latest frame is shown
+  bool m_adaptiveQuality = false; // goom's resolution follows the time of its frames
+  int m_targetFps = 60;
+  bool m_idleOnSilence = true; // goom fades out and stops making frames
+  bool m_traceEnabled = false; // a Chrome trace of the frames is written at Stop()
 
   int m_window_width;
   int m_window_height;
@@ -89,6 +104,7 @@ private:
   int m_window_ypos;
 
   int m_channels;
+  int m_samplesPerSec = 44100;
   std::string m_currentSongName;
   std::string m_lastSongName;
   bool m_titleChange = false;
@@ -102,14 +118,11 @@ private:
 
 #ifdef HAS_GL
   bool m_usePixelBufferObjects =
-      false; // 'true' is supposed to give better performance but it's not obvious.
+      false; // 'true' makes goom draw straight into the PBOs, Render() has no copy to do then.
       // And when 'true', there may be issues with screen refreshes when changing windows in Kodi.
+  pixel_buffer_ring m_pixelBuffers;
 #endif
   GLuint m_textureId = 0;
-  const static int g_numPbos = 3;
-  GLuint m_pboIds[g_numPbos];
-  unsigned char* m_pboGoomBuffer[g_numPbos];
-  int m_currentPboIndex;
   glm::mat4 m_projModelMatrix;
   GLuint m_vaoObject = 0;
   GLuint m_vertexVBO = 0;
@@ -120,21 +133,33 @@ private:
   // Goom's data itself
   PluginInfo* m_goom = nullptr;
 
-  // Audio buffer storage
+  // Audio buffer storage, written by Kodi's audio thread and read by the goom thread
+  // without a lock, m_audioEvent wakes up the goom thread.
   const static size_t g_circular_buffer_size = 16 * NUM_AUDIO_SAMPLES * AUDIO_SAMPLE_LEN;
-  circular_buffer<float> m_buffer = g_circular_buffer_size;
+  spsc_ring<float> m_buffer{g_circular_buffer_size};
+  ring_event m_audioEvent;
 
   // Goom process thread handles
-  bool m_threadExit = false;
+  std::atomic<bool> m_threadExit{false};
   std::thread m_workerThread;
-  std::mutex m_mutex;
-  std::condition_variable m_wait;
-
-  // Screen frames storage, m_activeQueue for next view and m_storedQueue to
-  // use on next goom round become active again.
-  static constexpr size_t g_maxActiveQueueLength = 20;
-  std::queue<std::shared_ptr<uint32_t>> m_activeQueue;
-  std::queue<std::shared_ptr<uint32_t>> m_storedQueue;
+
+  // Set by the goom thread when the silence made it stop, its last frame stays on screen
+  std::atomic<bool> m_idle{false};
+
+  // Only when tracing, kept until the next Start() in case Kodi's audio thread still uses it
+  std::unique_ptr<trace_recorder> m_trace;
+  std::atomic<int64_t> m_traceFrame{-1}; // the frame goom is making, for its stages
+
+  // Only used by the goom thread, when m_adaptiveQuality
+  std::unique_ptr<resolution_governor> m_governor;
+
+  // Screen frames storage, from the goom thread to Render(). Their pixels are buffers of
+  // goom_alloc_screenbuffer (in m_goomFrames), exchanged with goom's, or the PBOs of
+  // m_pixelBuffers.
+  std::unique_ptr<frame_exchanger<screen_frame>> m_frames;
+  std::vector<screen_frame> m_goomFrames;
+  bool m_framesFromGoom = true;
+  screen_frame* m_shownFrame = nullptr;
 
   // Start flag to know init was OK
   bool m_started = false;
@@ -0,0 +1,185 @@
+/*
+ *      Copyright (C) 2020 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <kodi/gui/gl/GL.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// A frame going from the goom thread to Render(): its pixels and their size (the buffer
+// may be bigger), and when they are in a pixel buffer object, the PBO and the fence of
+// its last upload.
+struct screen_frame
+{
+  uint32_t* pixels = nullptr;
+  int width = 0;
+  int height = 0;
+  unsigned long number = 0; // made by the goom thread in this order
+#ifdef HAS_GL
+  GLuint pbo = 0;
+  GLsync fence = nullptr;
+#endif
+};
+
+#ifdef HAS_GL
+
+// Pixel buffer objects the goom thread draws into, so that Render() has no copy to do.
+//
+// With GL 4.4 or ARB_buffer_storage the PBOs stay mapped (persistent and coherent),
+// a fence tells when the texture upload of a frame is done and it can be drawn again.
+// Otherwise each PBO is unmapped for its upload and mapped again before it goes back
+// to the goom thread.
+//
+// All the methods are called from the GL thread; the goom thread only writes the pixels
+// of the frames it is given.
+class pixel_buffer_ring
+{
+public:
+  bool create(size_t nb_frames, size_t frame_size)
+  {
+    persistent = has_buffer_storage();
+    size = frame_size;
+    frames.resize(nb_frames);
+    next = 0;
+    for (screen_frame& frame : frames)
+    {
+      glGenBuffers(1, &frame.pbo);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, frame.pbo);
+#ifdef GL_MAP_PERSISTENT_BIT
+      if (persistent)
+      {
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, persistent_flags);
+        frame.pixels = static_cast<uint32_t*>(
+            glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, persistent_flags));
+      }
+      else
+#endif
+      {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        map(frame);
+      }
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      if (frame.pixels == nullptr)
+      {
+        destroy();
+        return false;
+      }
+      std::memset(frame.pixels, 0, size);
+    }
+    return true;
+  }
+
+  void destroy()
+  {
+    for (screen_frame& frame : frames)
+    {
+      if (frame.fence)
+        glDeleteSync(frame.fence);
+      if (frame.pixels)
+      {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, frame.pbo);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+      }
+      glDeleteBuffers(1, &frame.pbo);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    frames.clear();
+  }
+
+  bool is_persistent() const { return persistent; }
+
+  // The frames one after the other, for the frame_exchanger.
+  screen_frame* next_frame() { return &frames[next++]; }
+
+  // A frame given back by Render(): true when the goom thread can draw into it again.
+  bool writable(screen_frame* frame)
+  {
+    if (frame->fence)
+    {
+      if (glClientWaitSync(frame->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+        return false;
+      glDeleteSync(frame->fence);
+      frame->fence = nullptr;
+    }
+    if (frame->pixels == nullptr)
+    {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, frame->pbo);
+      map(*frame);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    return frame->pixels != nullptr;
+  }
+
+  // Sends the frame to the bound texture.
+  void upload(screen_frame* frame, int width, int height)
+  {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, frame->pbo);
+    if (!persistent)
+    {
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+      frame->pixels = nullptr;
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (persistent)
+      frame->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+
+private:
+#ifdef GL_MAP_PERSISTENT_BIT
+  static constexpr GLbitfield persistent_flags =
+      GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+#endif
+
+  static bool has_buffer_storage()
+  {
+#ifdef GL_MAP_PERSISTENT_BIT
+    GLint major = 0, minor = 0, nb_extensions = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major > 4 || (major == 4 && minor >= 4))
+      return true;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &nb_extensions);
+    for (GLint i = 0; i < nb_extensions; i++)
+    {
+      const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+      if (name && std::strcmp(name, "GL_ARB_buffer_storage") == 0)
+        return true;
+    }
+#endif
+    return false;
+  }
+
+  // The PBO of the frame is bound, its old content is not needed any more.
+  void map(screen_frame& frame)
+  {
+    frame.pixels = static_cast<uint32_t*>(glMapBufferRange(
+        GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+  }
+
+  bool persistent = false;
+  size_t size = 0;
+  std::vector<screen_frame> frames;
+  size_t next = 0;
+};
+
+#endif // HAS_GL
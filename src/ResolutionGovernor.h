@@ -0,0 +1,145 @@
+/*
+ *      Copyright (C) 2020 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+// Picks the resolution goom draws at from the time its frames take, so that it keeps up
+// with a target frame rate whatever the machine. The GL quad scales the texture anyway.
+//
+// The resolutions go from a quarter to all of the biggest one, by eighths of its width.
+// The frame time is smoothed, and assumed proportional to the number of pixels:
+// - too close to the target period, it goes down at once, as many steps as needed;
+// - far enough below it at the next step up, for a while, it goes up one step.
+// The gap between the two thresholds, and a longer wait after each step up that had to be
+// undone, keep it from oscillating.
+class resolution_governor
+{
+public:
+  struct resolution
+  {
+    int width;
+    int height;
+  };
+
+  resolution_governor(int max_width, int max_height, std::chrono::microseconds target_period)
+    : target(static_cast<double>(target_period.count()))
+  {
+    for (int eighths = min_eighths; eighths <= 8; eighths++)
+    {
+      // even sizes, the zoom works on pixel pairs
+      levels.push_back({(max_width * eighths / 8) & ~1, (max_height * eighths / 8) & ~1});
+    }
+    // starts at 4 eighths, half the biggest size
+    level = 4 - min_eighths;
+    up_wait = min_up_wait;
+    changed();
+  }
+
+  const resolution& current() const { return levels[level]; }
+
+  // The time goom took for the frame just made, true when current() changed.
+  bool update(std::chrono::microseconds frame_time)
+  {
+    const double t = static_cast<double>(frame_time.count());
+
+    // the first frames after a change pay for it (new zoom maps, cold caches)
+    if (settle > 0)
+    {
+      settle--;
+      smoothed = -1.0;
+      return false;
+    }
+    smoothed = (smoothed < 0.0) ? t : smoothed + (t - smoothed) / smoothing;
+    frames_at_level++;
+
+    if (smoothed > down_threshold * target && level > 0)
+    {
+      const size_t from = level;
+      do
+      {
+        level--;
+      } while (level > 0 && predicted(level, from) > up_threshold * target);
+
+      // back down soon after going up: wait longer before the next try
+      if (went_up && frames_at_level < up_wait)
+        up_wait = (2 * up_wait < max_up_wait) ? 2 * up_wait : max_up_wait;
+      went_up = false;
+      return from != level && changed();
+    }
+
+    if (level + 1 < levels.size() && predicted(level + 1, level) < up_threshold * target)
+    {
+      if (++below_frames >= up_wait)
+      {
+        level++;
+        went_up = true;
+        return changed();
+      }
+    }
+    else
+    {
+      below_frames = 0;
+    }
+
+    // stable for long, the machine may have changed (other load, thermal throttling)
+    if (frames_at_level > max_up_wait)
+      up_wait = min_up_wait;
+    return false;
+  }
+
+private:
+  static constexpr int min_eighths = 2;
+  static constexpr double smoothing = 16.0;
+  static constexpr double down_threshold = 0.9;
+  static constexpr double up_threshold = 0.7;
+  static constexpr int settle_frames = 16;
+  static constexpr int min_up_wait = 120;
+  static constexpr int max_up_wait = 120 * 16;
+
+  // the smoothed time at level l, from the one measured at level at
+  double predicted(size_t l, size_t at) const
+  {
+    return smoothed * pixels(l) / pixels(at);
+  }
+
+  double pixels(size_t l) const { return static_cast<double>(levels[l].width) * levels[l].height; }
+
+  bool changed()
+  {
+    settle = settle_frames;
+    smoothed = -1.0;
+    below_frames = 0;
+    frames_at_level = 0;
+    return true;
+  }
+
+  const double target;
+  std::vector<resolution> levels;
+  size_t level;
+
+  double smoothed = -1.0; // microseconds, < 0 when there is no measure yet
+  int settle = 0;
+  int below_frames = 0;
+  int frames_at_level = 0;
+  int up_wait;
+  bool went_up = false;
+};
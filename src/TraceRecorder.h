@@ -0,0 +1,189 @@
+/*
+ *      Copyright (C) 2020 Team Kodi
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Events of the threads of the addon, written as Chrome trace events (JSON), which
+// Perfetto and chrome://tracing open as they are.
+//
+// The events go into a ring made at once, from any thread without a lock: recording
+// allocates nothing, and once it is full the oldest events make room for the new ones.
+// The threads are numbered by each recorder, in the order they first record something.
+// write() must only be called once the threads stopped recording.
+class trace_recorder
+{
+public:
+  using clock = std::chrono::steady_clock;
+
+  explicit trace_recorder(size_t capacity)
+    : events(capacity), origin(clock::now()), serial(next_serial().fetch_add(1) + 1)
+  {
+    for (auto& id : thread_ids)
+      id = std::thread::id();
+    for (auto& name : thread_names)
+      name = nullptr;
+  }
+
+  // The name of the calling thread in the trace, the last one given wins.
+  void name_thread(const char* name)
+  {
+    const int tid = thread_id();
+    if (tid < max_threads)
+      thread_names[tid].store(name, std::memory_order_relaxed);
+  }
+
+  // A span of the calling thread from start until now. name must be a literal (kept as is).
+  void complete(const char* name, clock::time_point start, int64_t frame = -1)
+  {
+    const clock::time_point end = clock::now();
+    record(name, 'X', start - origin, end - start, frame);
+  }
+
+  // Same, ending now after duration.
+  void complete(const char* name, std::chrono::nanoseconds duration, int64_t frame = -1)
+  {
+    record(name, 'X', clock::now() - duration - origin, duration, frame);
+  }
+
+  void instant(const char* name, int64_t frame = -1)
+  {
+    record(name, 'i', clock::now() - origin, std::chrono::nanoseconds(0), frame);
+  }
+
+  size_t recorded() const { return next.load(std::memory_order_relaxed); }
+
+  bool write(const std::string& path) const
+  {
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+      return false;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"goom\"}}");
+    for (int tid = 0; tid < next_tid.load(); tid++)
+    {
+      const char* name = thread_names[tid].load();
+      if (name != nullptr)
+        fprintf(file,
+                ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                "\"args\":{\"name\":\"%s\"}}",
+                tid, name);
+    }
+
+    const size_t count = next.load();
+    for (size_t i = count > events.size() ? count - events.size() : 0; i < count; i++)
+    {
+      const event& e = events[i % events.size()];
+      fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f", e.name,
+              e.phase, e.tid, e.ts_ns / 1000.0);
+      if (e.phase == 'X')
+        fprintf(file, ",\"dur\":%.3f", e.dur_ns / 1000.0);
+      else
+        fprintf(file, ",\"s\":\"t\"");
+      if (e.frame >= 0)
+        fprintf(file, ",\"args\":{\"frame\":%lld}", static_cast<long long>(e.frame));
+      fprintf(file, "}");
+    }
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+  }
+
+private:
+  static constexpr int max_threads = 32;
+
+  struct event
+  {
+    const char* name;
+    int64_t ts_ns;
+    int64_t dur_ns;
+    int64_t frame;
+    int tid;
+    char phase;
+  };
+
+  // Tells the recorders apart in the cache of thread_id(), 0 is none.
+  static std::atomic<uint64_t>& next_serial()
+  {
+    static std::atomic<uint64_t> last{0};
+    return last;
+  }
+
+  // The number of the calling thread in this recorder, max_threads for the ones beyond.
+  int thread_id()
+  {
+    // the last recorder the thread recorded in
+    static thread_local uint64_t cached_serial = 0;
+    static thread_local int cached_tid = 0;
+    if (cached_serial == serial)
+      return cached_tid;
+
+    // known by this recorder (the thread recorded in another one since), or a new one
+    const std::thread::id self = std::this_thread::get_id();
+    const int count = next_tid.load(std::memory_order_acquire);
+    int tid = 0;
+    while (tid < count && thread_ids[tid].load(std::memory_order_acquire) != self)
+      tid++;
+    if (tid == count)
+    {
+      tid = next_tid.load(std::memory_order_relaxed);
+      while (tid < max_threads &&
+             !next_tid.compare_exchange_weak(tid, tid + 1, std::memory_order_relaxed))
+      {
+      }
+      if (tid < max_threads)
+        thread_ids[tid].store(self, std::memory_order_release);
+      else
+        tid = max_threads;
+    }
+    cached_serial = serial;
+    cached_tid = tid;
+    return tid;
+  }
+
+  void record(const char* name,
+              char phase,
+              clock::duration ts,
+              clock::duration duration,
+              int64_t frame)
+  {
+    event& e = events[next.fetch_add(1, std::memory_order_relaxed) % events.size()];
+    e.name = name;
+    e.ts_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(ts).count();
+    e.dur_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    e.frame = frame;
+    e.tid = thread_id();
+    e.phase = phase;
+  }
+
+  std::vector<event> events;
+  std::atomic<size_t> next{0};
+  const clock::time_point origin;
+  const uint64_t serial;
+  std::atomic<int> next_tid{0};
+  std::atomic<std::thread::id> thread_ids[max_threads];
+  std::atomic<const char*> thread_names[max_threads];
+};